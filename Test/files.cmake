@@ -0,0 +1,43 @@
+# files.cmake checks that a run over several files lists
+# each of them as a run over that file alone would, however
+# the files are read and compiled; run it with cmake -P,
+# TINY and DIR set
+# 检查多文件编译对每个文件给出的列表与单独编译相同，无论文件如何读取和编译
+
+file(GLOB sources ${CMAKE_CURRENT_LIST_DIR}/*.txt)
+list(SORT sources)
+set(want "")
+foreach (src ${sources})
+    execute_process(COMMAND ${TINY} ${src} OUTPUT_VARIABLE alone)
+    string(APPEND want "${alone}")
+endforeach ()
+
+# io_uring或pread线程池读取；额度小于文件时就地扫描；-parallel时在多个线程上编译
+foreach (run "TINY_IO_URING=1" "TINY_IO_URING=0" "TINY_INFLIGHT_BYTES=200;TINY_QUEUE_DEPTH=1"
+        "TINY_IO_URING=1;-parallel=3" "TINY_IO_URING=0;-parallel=2"
+        "TINY_INFLIGHT_BYTES=200;-parallel=2")
+    set(env "")
+    set(options "")
+    foreach (arg ${run})
+        if (arg MATCHES "^-")
+            list(APPEND options ${arg})
+        else ()
+            list(APPEND env ${arg})
+        endif ()
+    endforeach ()
+    execute_process(COMMAND ${CMAKE_COMMAND} -E env ${env} ${TINY} ${options} ${sources}
+            OUTPUT_VARIABLE got RESULT_VARIABLE status)
+    if (NOT status EQUAL 0 OR NOT got STREQUAL want)
+        file(WRITE ${DIR}/files.out "${got}")
+        message(FATAL_ERROR "${run}: the listing in ${DIR}/files.out differs from single-file runs")
+    endif ()
+endforeach ()
+
+# 无法读取的文件被报告，其余文件照常编译
+list(GET sources 0 src)
+execute_process(COMMAND ${TINY} -parallel=2 ${src} ${DIR}/missing.tny ${src}
+        OUTPUT_VARIABLE got ERROR_VARIABLE err RESULT_VARIABLE status)
+execute_process(COMMAND ${TINY} ${src} OUTPUT_VARIABLE alone)
+if (NOT status EQUAL 1 OR NOT got STREQUAL "${alone}${alone}" OR NOT err MATCHES "missing.tny not found")
+    message(FATAL_ERROR "a missing file among others is not reported as with a single file")
+endif ()
@@ -0,0 +1,107 @@
+/****************************************************/
+/* File: fnumbench.c                                */
+/* Times FNUM conversion against strtod             */
+/* 比较FNUM转换与strtod的耗时                       */
+/****************************************************/
+
+#include "globals.h"
+#include "fnum.h"
+#include <time.h>
+
+/* LITERALS is the number of literals of each kind */
+/* LITERALS为每类字面量的个数 */
+#define LITERALS 200000
+
+/* ROUNDS is how many times each set is converted */
+/* ROUNDS为每组字面量转换的次数 */
+#define ROUNDS 10
+
+static uint64_t seed = 88172645463325252ULL;
+
+/* next returns the next number of an xorshift sequence */
+/* next返回xorshift序列的下一个数 */
+static uint64_t next(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+/* literal writes a literal of the given kind to lit:
+   short ones as found in TINY sources, the shortest
+   round-trip form of a random double, or a mantissa
+   too long for 64 bits */
+/* literal将给定种类的字面量写入lit：TINY源程序中常见的短字面量、
+   随机double的最短往返形式，或超出64位的长尾数 */
+static void literal(int kind, char *lit) {
+    uint64_t bits = next() & 0x7FEFFFFFFFFFFFFFULL;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    switch (kind) {
+        case 0:
+            sprintf(lit, "%d.%de%d", (int) (next() % 1000), (int) (next() % 100),
+                    (int) (next() % 21) - 10);
+            break;
+        case 1:
+            sprintf(lit, "%.17g", d);
+            break;
+        default:
+            sprintf(lit, "%.30e", d);
+            break;
+    }
+}
+
+/* seconds times ROUNDS conversions of the n literals in
+   lits, with floatValue or with strtod, and adds the
+   results to sum so that none is optimized away */
+/* seconds计时lits中n个字面量用floatValue或strtod的ROUNDS轮转换，
+   结果累加到sum以免被优化掉 */
+static double seconds(char (*lits)[48], int n, bool fnum, double *sum) {
+    clock_t start = clock();
+    int r, i;
+    for (r = 0; r < ROUNDS; r++)
+        for (i = 0; i < n; i++) {
+            double v;
+            if (fnum)
+                floatValue(lits[i], &v);
+            else
+                v = strtod(lits[i], NULL);
+            *sum += v;
+        }
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void) {
+    static const char *const kinds[] = {"short", "17 digits", "30 digits"};
+    char (*lits)[48] = (char (*)[48]) malloc(LITERALS * sizeof(*lits));
+    double sum = 0;
+    int k, i;
+    if (lits == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    printf("%-10s %12s %12s\n", "literals", "floatValue", "strtod");
+    for (k = 0; k < 3; k++) {
+        double fnum, libc;
+        int differ = 0;
+        for (i = 0; i < LITERALS; i++) {
+            double a, b;
+            literal(k, lits[i]);
+            floatValue(lits[i], &a);
+            b = strtod(lits[i], NULL);
+            differ += memcmp(&a, &b, sizeof(a)) != 0;
+        }
+        fnum = seconds(lits, LITERALS, true, &sum);
+        libc = seconds(lits, LITERALS, false, &sum);
+        printf("%-10s %9.1f ns %9.1f ns\n", kinds[k],
+               fnum * 1e9 / ((double) LITERALS * ROUNDS),
+               libc * 1e9 / ((double) LITERALS * ROUNDS));
+        if (differ > 0) {
+            fprintf(stderr, "%d %s literals differ from strtod\n", differ, kinds[k]);
+            free(lits);
+            return 1;
+        }
+    }
+    free(lits);
+    return sum == 0;
+}
@@ -0,0 +1,7 @@
+# listing.cmake runs TINY with OPTIONS over SRC and checks
+# that the listing is the one in WANT; run it with cmake -P
+execute_process(COMMAND ${TINY} ${OPTIONS} ${SRC} OUTPUT_FILE ${OUT})
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUT} ${WANT} RESULT_VARIABLE differ)
+if (differ)
+    message(FATAL_ERROR "the listing in ${OUT} differs from ${WANT}")
+endif ()
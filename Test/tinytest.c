@@ -0,0 +1,850 @@
+/****************************************************/
+/* File: tinytest.c                                 */
+/* Checks of the TINY compiler library              */
+/* TINY编译器库的检查                               */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "ast.h"
+#include "fnum.h"
+
+/* failures counts the checks that did not hold */
+/* failures统计不成立的检查数 */
+static int failures = 0;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/* open returns a scanner over the NUL-terminated src
+   with no listing */
+/* open返回以NUL结尾的src的扫描器，不输出列表 */
+static TinyScanner *open(const char *src, unsigned flags) {
+    TinyScanner *sc = tinyOpenBuffer(src, strlen(src), flags, NULL);
+    if (sc == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return sc;
+}
+
+/* testTokens checks kinds, lexemes, lines and values */
+/* testTokens检查token的种类、词素、行号和值 */
+static void testTokens(void) {
+    static const char src[] =
+            "if x1 := 42 then\n"
+            "  y := 3.25e2 + 1.5; { a\n"
+            "  comment } write 'hi'\n"
+            "z := 99999999999 <= 0.000000000000000000000000001234\n";
+    static const struct {
+        TinyTokenType kind;
+        const char *text;
+        int line;
+    } want[] = {
+            {TINY_IF,     "if",   1}, {TINY_ID,    "x1",     1}, {TINY_ASSIGN, ":=", 1},
+            {TINY_NUM,    "42",   1}, {TINY_THEN,  "then",   1}, {TINY_ID,     "y",  2},
+            {TINY_ASSIGN, ":=",   2}, {TINY_FNUM,  "3.25e2", 2}, {TINY_PLUS,   "+",  2},
+            {TINY_FNUM,   "1.5",  2}, {TINY_SEMI,  ";",      2}, {TINY_WRITE,  "write", 3},
+            {TINY_STR,    "hi",   3}, {TINY_ID,    "z",      4}, {TINY_ASSIGN, ":=", 4},
+            {TINY_NUM,    "99999999999", 4}, {TINY_LE, "<=", 4},
+            {TINY_FNUM,   "0.000000000000000000000000001234", 4}, {TINY_ENDFILE, "", 4}};
+    TinyScanner *sc = open(src, 0);
+    size_t i;
+    for (i = 0; i < sizeof(want) / sizeof(want[0]); i++) {
+        TinyTokenType kind = tinyNextToken(sc);
+        CHECK(kind == want[i].kind);
+        if (kind != TINY_ENDFILE) {
+            CHECK(!strcmp(tinyTokenString(sc), want[i].text));
+            CHECK(tinyTokenLine(sc) == want[i].line);
+        }
+        if (kind == TINY_NUM && i == 3)
+            CHECK(tinyTokenValue(sc) == 42);
+        if (kind == TINY_FNUM && i == 7)
+            CHECK(tinyTokenFloat(sc) == 325.0);
+        if (kind == TINY_FNUM && i == 9)
+            CHECK(tinyTokenFloat(sc) == 1.5);
+        if (kind == TINY_FNUM && i == 17)
+            CHECK(tinyTokenFloat(sc) == strtod(want[i].text, NULL));
+    }
+    /* 溢出的数是唯一的错误 */
+    CHECK(tinyErrorCount(sc) == 1);
+    CHECK(tinyNextToken(sc) == TINY_ENDFILE);
+    tinyClose(sc);
+}
+
+/* a token as seen by the checkpoint test */
+/* 检查点测试所见的token */
+typedef struct {
+    TinyTokenType kind;
+    int line;
+    size_t offset;
+} Seen;
+
+/* scanRest scans to the end, keeping at most max tokens
+   in seen, and returns how many there were */
+/* scanRest扫描到结束，在seen中保留至多max个token，返回token数 */
+static int scanRest(TinyScanner *sc, Seen *seen, int max) {
+    int n = 0;
+    for (;;) {
+        TinyTokenType kind = tinyNextToken(sc);
+        if (n < max) {
+            seen[n].kind = kind;
+            seen[n].line = tinyTokenLine(sc);
+            seen[n].offset = tinyTokenOffset(sc);
+        }
+        n++;
+        if (kind == TINY_ENDFILE)
+            return n;
+    }
+}
+
+/* testCheckpoint checks that restoring a checkpoint
+   scans the same tokens, errors and lines again */
+/* testCheckpoint检查恢复检查点后再次扫描得到相同的token、错误和行号 */
+static void testCheckpoint(void) {
+    static const char src[] =
+            "read x; { first\n"
+            "line } y := 'two\n"
+            "lines' @ 123456789012;\n"
+            "write x\n";
+    Seen first[32];
+    Seen again[32];
+    TinyCheckpoint cp;
+    TinyCheckpoint mark;
+    TinyLookahead *la;
+    const TinyToken *t;
+    const TinyDiagnostic *g;
+    TinyScanner *sc = open(src, 0);
+    int errors;
+    int n;
+    int i;
+    tinyNextToken(sc);
+    tinyNextToken(sc);
+    tinySave(sc, &cp);
+    n = scanRest(sc, first, 32);
+    errors = tinyErrorCount(sc);
+    CHECK(errors == 3);
+    tinyRestore(sc, &cp);
+    CHECK(tinyErrorCount(sc) == 0);
+    CHECK(scanRest(sc, again, 32) == n);
+    for (i = 0; i < n && i < 32; i++) {
+        CHECK(first[i].kind == again[i].kind);
+        CHECK(first[i].line == again[i].line);
+        CHECK(first[i].offset == again[i].offset);
+    }
+    CHECK(tinyErrorCount(sc) == errors);
+    tinyClose(sc);
+
+    /* 预读缓冲区上的标记与回退 */
+    sc = open(src, 0);
+    la = tinyLookaheadOpen(sc, 3);
+    CHECK(la != NULL);
+    CHECK(tinyPeek(la, 2)->kind == TINY_SEMI);
+    CHECK(tinyPeek(la, 3) == NULL);
+    CHECK(tinyPeek(la, -1) == NULL);
+    CHECK(tinyAdvance(la)->kind == TINY_READ);
+    tinyMark(la, &mark);
+    t = tinyAdvance(la);
+    CHECK(t->kind == TINY_ID && !strcmp(t->text, "x"));
+    CHECK(tinyAdvance(la)->kind == TINY_SEMI);
+    t = tinyAdvance(la);
+    CHECK(t->kind == TINY_ID && !strcmp(t->text, "y") && t->line == 2);
+    tinyReset(la, &mark);
+    t = tinyAdvance(la);
+    CHECK(t->kind == TINY_ID && !strcmp(t->text, "x") && t->line == 1);
+    tinyLookaheadClose(la);
+    tinyClose(sc);
+
+    /* 恢复检查点时丢弃此后的诊断，包括合并进已有诊断的字符 */
+    sc = open("x @ # y : 1 @\n", TINY_DIAGNOSTICS);
+    tinySetErrorLimit(sc, 3);
+    tinyNextToken(sc);
+    tinyNextToken(sc);
+    tinySave(sc, &cp);
+    while (tinyNextToken(sc) != TINY_ENDFILE);
+    tinyDiagnostics(sc, &n);
+    CHECK(n == 4);
+    tinyRestore(sc, &cp);
+    g = tinyDiagnostics(sc, &n);
+    CHECK(n == 1 && g[0].count == 1 && g[0].length == 1);
+    while (tinyNextToken(sc) != TINY_ENDFILE);
+    g = tinyDiagnostics(sc, &n);
+    CHECK(n == 4);
+    if (n == 4) {
+        CHECK(g[0].code == TINY_DIAG_CHAR && g[0].count == 2 && g[0].length == 3);
+        CHECK(g[1].code == TINY_DIAG_ASSIGN);
+        CHECK(g[2].code == TINY_DIAG_CHAR && g[2].count == 1);
+        CHECK(g[3].code == TINY_DIAG_LIMIT);
+    }
+    tinyClose(sc);
+
+    /* 在另一个扫描器上恢复：此前的诊断不带过去，也不与之合并 */
+    sc = open("x @ # y\n", TINY_DIAGNOSTICS);
+    tinyNextToken(sc);
+    tinyNextToken(sc);
+    tinySave(sc, &cp);
+    tinyClose(sc);
+    sc = open("x @ # z\n", TINY_DIAGNOSTICS);
+    tinyRestore(sc, &cp);
+    CHECK(tinyNextToken(sc) == TINY_ERROR);
+    CHECK(tinyNextToken(sc) == TINY_ID && !strcmp(tinyTokenString(sc), "z"));
+    g = tinyDiagnostics(sc, &n);
+    CHECK(n == 1 && g[0].offset == 4 && g[0].count == 1);
+    CHECK(tinyErrorCount(sc) == 2);
+    tinyClose(sc);
+}
+
+/* testDiagnostics checks how errors are collected */
+/* testDiagnostics检查错误的收集方式 */
+static void testDiagnostics(void) {
+    static const char src[] =
+            "x := 1 @#$ y\n"
+            "@ z : 2\n"
+            "'open\n";
+    const TinyDiagnostic *g;
+    TinyScanner *sc = open(src, TINY_DIAGNOSTICS);
+    int count;
+    while (tinyNextToken(sc) != TINY_ENDFILE);
+    g = tinyDiagnostics(sc, &count);
+    CHECK(count == 4);
+    if (count == 4) {
+        /* 相邻的非法字符合并为一个诊断 */
+        CHECK(g[0].code == TINY_DIAG_CHAR && g[0].count == 3 && g[0].line == 1);
+        CHECK(g[0].offset == 7 && g[0].length == 3);
+        /* 中间有token时不合并 */
+        CHECK(g[1].code == TINY_DIAG_CHAR && g[1].count == 1 && g[1].line == 2);
+        CHECK(g[2].code == TINY_DIAG_ASSIGN && g[2].line == 2);
+        CHECK(g[3].code == TINY_DIAG_OPEN_STRING && g[3].line == 3);
+    }
+    CHECK(tinyErrorCount(sc) == 6);
+    tinyClose(sc);
+
+    /* 达到上限后停止扫描 */
+    sc = open("@ x @ y @ z @\n", TINY_DIAGNOSTICS);
+    tinySetErrorLimit(sc, 2);
+    while (tinyNextToken(sc) != TINY_ENDFILE);
+    g = tinyDiagnostics(sc, &count);
+    CHECK(count == 3);
+    if (count == 3)
+        CHECK(g[2].code == TINY_DIAG_LIMIT);
+    tinyClose(sc);
+}
+
+/* scanTo scans src with its listing written to out */
+/* scanTo扫描src，列表写入out */
+static void scanTo(const char *src, unsigned flags, FILE *out) {
+    TinyScanner *sc = tinyOpenBuffer(src, strlen(src), flags, out);
+    CHECK(sc != NULL);
+    if (sc != NULL) {
+        while (tinyNextToken(sc) != TINY_ENDFILE);
+        tinyClose(sc);
+    }
+    fflush(out);
+}
+
+/* readBack returns what was written to the file f as
+   a string to be freed */
+/* readBack以需要释放的字符串返回写入文件f的内容 */
+static char *readBack(FILE *f) {
+    long len = ftell(f);
+    char *text = (char *) calloc(1, len > 0 ? (size_t) len + 1 : 1);
+    rewind(f);
+    if (text != NULL && len > 0 && fread(text, 1, (size_t) len, f) != (size_t) len)
+        text[0] = '\0';
+    return text;
+}
+
+/* sameText tells whether a and b hold the same bytes */
+/* sameText判断a与b的内容是否相同 */
+static bool sameText(FILE *a, FILE *b) {
+    int c;
+    rewind(a);
+    rewind(b);
+    do {
+        c = getc(a);
+        if (c != getc(b))
+            return false;
+    } while (c != EOF);
+    return true;
+}
+
+/* testEcho checks that a listing of source lines and
+   errors written in batches comes out in order */
+/* testEcho检查批量写出的源程序行和错误的列表顺序正确 */
+static void testEcho(void) {
+    static const char *srcs[] = {
+            "x := 1;\ny := @;\nz := 3\n",
+            "read x; 99999999999\n'two\nlines' { open\n",
+            "no newline @"};
+    size_t i;
+    for (i = 0; i < sizeof(srcs) / sizeof(srcs[0]); i++) {
+        /* 临时文件有文件描述符，回显按批写出；内存流没有，逐行写出 */
+        FILE *batched = tmpfile();
+        char *mem = NULL;
+        size_t size = 0;
+        FILE *plain = open_memstream(&mem, &size);
+        char *got;
+        CHECK(batched != NULL && plain != NULL);
+        if (batched == NULL || plain == NULL)
+            return;
+        scanTo(srcs[i], TINY_ECHO_SOURCE, batched);
+        scanTo(srcs[i], TINY_ECHO_SOURCE, plain);
+        fclose(plain);
+        got = readBack(batched);
+        CHECK(got != NULL && !strcmp(got, mem));
+#ifndef TINY_NO_TRACE
+        if (i == 0)
+            CHECK(got != NULL && !strcmp(got, "1: x := 1;\n2: y := @;\n\t2: ERROR: @\n3: z := 3\n"));
+#endif
+        free(got);
+        free(mem);
+        fclose(batched);
+    }
+}
+
+/* tokensOf scans all tokens of sc into out, one line
+   for each with its kind, line and lexeme */
+/* tokensOf将sc的所有token写入out，每个token一行，含种类、行号和词素 */
+static void tokensOf(TinyScanner *sc, FILE *out) {
+    TinyTokenType kind;
+    do {
+        kind = tinyNextToken(sc);
+        fprintf(out, "%d %d %s\n", (int) kind, tinyTokenLine(sc), kind == TINY_ENDFILE ? "" : tinyTokenString(sc));
+    } while (kind != TINY_ENDFILE);
+}
+
+/* chunked scans src as count chunks, one after the
+   other, writing their listings to listing and their
+   tokens to tokens; a chunk's ENDFILE is only written
+   by the last one */
+/* chunked将src分count块依次扫描，列表写入listing，token写入tokens；
+   只有最后一块的ENDFILE被写出 */
+static void chunked(const char *src, int count, FILE *listing, FILE *tokens) {
+    size_t len = strlen(src);
+    TinyChunk *chunks = (TinyChunk *) malloc((size_t) count * sizeof(TinyChunk));
+    int i;
+    if (chunks == NULL)
+        exit(1);
+    tinyChunkSplit(src, len, chunks, count);
+    /* 推测的顺序无关紧要，倒序扫描 */
+    for (i = count - 1; i >= 0; i--)
+        tinyChunkScan(src, &chunks[i]);
+    tinyChunkLink(chunks, count);
+    for (i = 0; i < count; i++) {
+        TinyScanner *sc = tinyOpenChunk(src, &chunks[i], TINY_ECHO_SOURCE | TINY_TRACE_SCAN, listing);
+        CHECK(sc != NULL);
+        if (sc != NULL) {
+            while (tinyNextToken(sc) != TINY_ENDFILE);
+            tinyClose(sc);
+        }
+        sc = tinyOpenChunk(src, &chunks[i], 0, NULL);
+        if (sc != NULL) {
+            TinyTokenType kind;
+            while ((kind = tinyNextToken(sc)) != TINY_ENDFILE)
+                fprintf(tokens, "%d %d %s\n", (int) kind, tinyTokenLine(sc), tinyTokenString(sc));
+            if (chunks[i].last)
+                fprintf(tokens, "%d %d \n", (int) kind, tinyTokenLine(sc));
+            tinyClose(sc);
+        }
+    }
+    free(chunks);
+}
+
+/* sameChunked tells whether scanning src as count
+   chunks lists and returns what one scanner does */
+/* sameChunked判断将src分count块扫描得到的列表和token是否与一个扫描器相同 */
+static bool sameChunked(const char *src, int count) {
+    FILE *wantList = tmpfile();
+    FILE *wantTokens = tmpfile();
+    FILE *gotList = tmpfile();
+    FILE *gotTokens = tmpfile();
+    TinyScanner *sc;
+    bool same = false;
+    if (wantList != NULL && wantTokens != NULL && gotList != NULL && gotTokens != NULL) {
+        scanTo(src, TINY_ECHO_SOURCE | TINY_TRACE_SCAN, wantList);
+        sc = open(src, 0);
+        tokensOf(sc, wantTokens);
+        tinyClose(sc);
+        chunked(src, count, gotList, gotTokens);
+        fflush(gotList);
+        same = sameText(wantList, gotList) && sameText(wantTokens, gotTokens);
+    }
+    if (wantList != NULL)
+        fclose(wantList);
+    if (wantTokens != NULL)
+        fclose(wantTokens);
+    if (gotList != NULL)
+        fclose(gotList);
+    if (gotTokens != NULL)
+        fclose(gotTokens);
+    return same;
+}
+
+/* testChunks checks that sources split into chunks of
+   every size down to one byte scan as one piece does,
+   with comments and strings across chunk boundaries */
+/* testChunks检查源程序分成直到一个字节的各种大小的块后，扫描结果与整体扫描相同，
+   包括跨越块边界的注释和字符串 */
+static void testChunks(void) {
+    static const char *srcs[] = {
+            "read x; { a comment\nover { three\nlines } write x\n",
+            "s := 'a { not\na comment';\n{ 'not a\nstring' }\nx := 1\n",
+            "{\n}\n'\n'\n{'}'{'\n}\n",
+            "x := 1 @ 2.5e\n99999999999 ab2\ny :",
+            "{ never\nclosed\n\n",
+            "'never\nclosed\n",
+            ""};
+    static const char alphabet[] = "ab1 {}'\n\n:=@;.e";
+    char random[160];
+    unsigned seed = 1;
+    size_t i;
+    int count;
+    for (i = 0; i < sizeof(srcs) / sizeof(srcs[0]); i++)
+        for (count = 1; count <= (int) strlen(srcs[i]) + 2; count++)
+            if (!sameChunked(srcs[i], count)) {
+                fprintf(stderr, "source %d in %d chunks\n", (int) i, count);
+                CHECK(false);
+            }
+    /* 随机源程序 */
+    for (i = 0; i < 200; i++) {
+        size_t n = 0;
+        size_t len;
+        seed = seed * 1103515245u + 12345u;
+        len = (seed >> 16) % (sizeof(random) - 1);
+        for (n = 0; n < len; n++) {
+            seed = seed * 1103515245u + 12345u;
+            random[n] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+        }
+        random[len] = '\0';
+        count = 1 + (int) (i % 40);
+        if (!sameChunked(random, count)) {
+            fprintf(stderr, "random source in %d chunks: %s\n", count, random);
+            CHECK(false);
+        }
+    }
+}
+
+/* sameFloat tells whether the FNUM literal s scans to
+   the double strtod gives, with overflow reported */
+/* sameFloat判断FNUM字面量s扫描得到的double是否与strtod相同，
+   并且溢出时被报告 */
+static bool sameFloat(const char *s) {
+    double want = strtod(s, NULL);
+    double got;
+    bool ok = floatValue(s, &got);
+    TinyScanner *sc = open(s, 0);
+    bool same = ok == (want <= DBL_MAX) && memcmp(&got, &want, sizeof(got)) == 0
+                && tinyNextToken(sc) == TINY_FNUM && tinyErrorCount(sc) == !ok;
+    got = tinyTokenFloat(sc);
+    same = same && memcmp(&got, &want, sizeof(got)) == 0;
+    tinyClose(sc);
+    if (!same)
+        fprintf(stderr, "float literal %s\n", s);
+    return same;
+}
+
+/* testFloats checks FNUM values against strtod around
+   the limits of the fast path (mantissa 2^53, exponent
+   22 and 22 + 15), ties, subnormals, overflow, long
+   mantissas, and on random literals */
+/* testFloats在快速路径的边界（尾数2^53，指数22和22 + 15）、
+   恰在中点、非规格化数、溢出、长尾数附近以及随机字面量上与strtod比较FNUM的值 */
+static void testFloats(void) {
+    static const char *const edges[] = {
+            "9007199254740992.0", "9007199254740993.0", "9007199254740994.0",
+            "9007199254740995.0", "18014398509481985.0", "1e22", "1e23", "1e-22",
+            "1e-23", "9007199254740992e22", "9007199254740993e22", "9007199254740992e-22",
+            "9007199254740993e-22", "1e37", "123e35", "123e37", "9007199254740992e15",
+            "9007199254740993e15", "900719925474099e37", "900719925474099e38", "0.1",
+            "0.3", "3.14159265358979323846264338327950288", "2.2250738585072014e-308",
+            "2.2250738585072011e-308", "4.9406564584124654e-324", "2.4703282292062327e-324",
+            "2.4703282292062328e-324", "1e-400", "1.7976931348623157e308",
+            "1.7976931348623158e308", "1.7976931348623159e308", "1e309", "1e99999999",
+            "0.0", "0e500", "12345678901234567890.5", "9999999999999999999.0",
+            "10000000000000000001.0", "9007199254740992.00000000000000000001",
+            "9007199254740993.00000000000000000001", "7.038531e-26", "8.98846567431158e307",
+            "1.00000000000000011102230246251565404236316680908203125",
+            "1.00000000000000011102230246251565404236316680908203124",
+            "1.00000000000000011102230246251565404236316680908203126"};
+    size_t i;
+    unsigned seed = 29;
+    for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+        CHECK(sameFloat(edges[i]));
+    /* 随机的尾数位数、小数点位置和指数 */
+    for (i = 0; i < 20000; i++) {
+        char lit[64];
+        int digits = 1 + (int) ((seed = seed * 1103515245u + 12345u) >> 16) % 24;
+        int point = (int) ((seed = seed * 1103515245u + 12345u) >> 16) % (digits + 1);
+        int exp10 = (int) ((seed = seed * 1103515245u + 12345u) >> 16) % 700 - 350;
+        int n = 0, d;
+        for (d = 0; d < digits; d++) {
+            if (d == point && d > 0)
+                lit[n++] = '.';
+            lit[n++] = (char) ('0' + ((seed = seed * 1103515245u + 12345u) >> 16) % 10);
+        }
+        sprintf(lit + n, "e%d", exp10);
+        CHECK(sameFloat(lit));
+    }
+}
+
+/* node makes a tree node with a name or a value */
+/* node创建带名字或值的树节点 */
+static TreeNode *node(NodeKind nodekind, int kind, int lineno, const char *name, int val) {
+    TreeNode *t = nodekind == StmtK ? newStmtNode((StmtKind) kind, lineno) : newExpNode((ExpKind) kind, lineno);
+    if (t == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    if (name != NULL)
+        nameSet(&t->attr.name, name);
+    else
+        t->attr.val = val;
+    return t;
+}
+
+/* freeTree frees a tree made by node */
+/* freeTree释放node创建的树 */
+static void freeTree(TreeNode *tree) {
+    while (tree != NULL) {
+        TreeNode *next = tree->sibling;
+        int i;
+        for (i = 0; i < MAXCHILDREN; i++)
+            freeTree(tree->child[i]);
+        if (tree->nodekind == StmtK ? tree->kind.stmt == AssignK || tree->kind.stmt == ReadK : tree->kind.exp == IdK)
+            nameFree(&tree->attr.name);
+        free(tree);
+        tree = next;
+    }
+}
+
+/* patch copies the AST file at from to to with the
+   link of node i set to rel, child c or the sibling
+   when c is MAXCHILDREN */
+/* patch将from处的AST文件复制到to，并把节点i的第c个子链接（c为MAXCHILDREN时为兄弟链接）设为rel */
+static void patch(const char *from, const char *to, uint32_t i, int c, int32_t rel) {
+    static char buf[4096];
+    FILE *f = fopen(from, "rb");
+    size_t len = f != NULL ? fread(buf, 1, sizeof(buf), f) : 0;
+    TinyAstNode *n = (TinyAstNode *) (buf + sizeof(AstHeader)) + i;
+    if (f != NULL)
+        fclose(f);
+    if (c < MAXCHILDREN)
+        n->child[c] = rel;
+    else
+        n->sibling = rel;
+    f = fopen(to, "wb");
+    CHECK(f != NULL && fwrite(buf, 1, len, f) == len);
+    if (f != NULL)
+        fclose(f);
+}
+
+/* DEEP is the depth of the tree in testDeepAst, more
+   than recursion on the C stack would survive */
+/* DEEP为testDeepAst中树的深度，超过在C栈上递归所能承受的深度 */
+#define DEEP 1000000
+
+/* testDeepAst checks that a tree DEEP nodes deep is
+   written, read back and freed */
+/* testDeepAst检查深度为DEEP的树能被写出、读回和释放 */
+static void testDeepAst(const char *path) {
+    TreeNode *tree = node(ExpK, IdK, 1, "a_name_too_long_to_keep_inline", 0);
+    TreeNode *t = tree;
+    TreeNode *back;
+    TinyAstFile *file;
+    FILE *out;
+    uint32_t count = 0;
+    int depth;
+    for (depth = 1; depth < DEEP; depth++) {
+        t->child[0] = node(ExpK, depth % 2 ? OpK : IdK, 1, depth % 2 ? NULL : "x", depth % 2 ? MINUS : 0);
+        t = t->child[0];
+    }
+    out = fopen(path, "wb");
+    CHECK(out != NULL && astWrite(out, tree));
+    if (out != NULL)
+        fclose(out);
+    file = tinyAstOpen(path);
+    CHECK(file != NULL);
+    if (file != NULL) {
+        tinyAstNodes(file, &count);
+        CHECK(count == DEEP);
+        back = astTree(file);
+        CHECK(back != NULL);
+        for (depth = 0, t = back; t != NULL; depth++, t = t->child[0])
+            if (depth % 2 ? t->kind.exp != OpK || t->attr.op != MINUS
+                          : t->kind.exp != IdK || strcmp(nameText(&t->attr.name), depth ? "x" : nameText(&tree->attr.name)))
+                break;
+        CHECK(t == NULL && depth == DEEP);
+        astFree(back);
+        tinyAstClose(file);
+    }
+    remove(path);
+    /* freeTree会在孩子上递归 */
+    while (tree != NULL) {
+        t = tree->child[0];
+        tree->child[0] = NULL;
+        freeTree(tree);
+        tree = t;
+    }
+}
+
+/* testAst checks that a tree survives an AST file and
+   that files whose nodes do not form a tree are refused */
+/* testAst检查树经AST文件往返后不变，且节点不构成树的文件被拒绝 */
+static void testAst(void) {
+    static const char *path = "tinytest.ast";
+    static const char *bad = "tinytest-bad.ast";
+    TreeNode *tree = node(StmtK, ReadK, 1, "x", 0);
+    TreeNode *loop = node(StmtK, RepeatK, 2, NULL, 0);
+    TreeNode *assign = node(StmtK, AssignK, 3, "x", 0);
+    TreeNode *minus = node(ExpK, OpK, 3, NULL, 0);
+    TreeNode *until = node(ExpK, OpK, 4, NULL, 0);
+    TreeNode *write = node(StmtK, WriteK, 5, NULL, 0);
+    const TinyAstNode *nodes;
+    TinyAstFile *file;
+    TreeNode *back;
+    FILE *want = tmpfile();
+    FILE *got = tmpfile();
+    FILE *out;
+    uint32_t count;
+    tree->sibling = loop;
+    loop->sibling = write;
+    loop->child[0] = assign;
+    loop->child[1] = until;
+    assign->child[0] = minus;
+    minus->attr.op = MINUS;
+    minus->child[0] = node(ExpK, IdK, 3, "x", 0);
+    minus->child[1] = node(ExpK, ConstK, 3, NULL, 1);
+    until->attr.op = EQ;
+    until->type = Boolean;
+    until->child[0] = node(ExpK, IdK, 4, "a_name_too_long_to_keep_inline", 0);
+    until->child[1] = node(ExpK, ConstK, 4, NULL, 0);
+    write->child[0] = node(ExpK, StrK, 5, NULL, 0);
+    out = fopen(path, "wb");
+    CHECK(out != NULL && astWrite(out, tree));
+    if (out != NULL)
+        fclose(out);
+
+    file = tinyAstOpen(path);
+    CHECK(file != NULL);
+    if (file != NULL) {
+        nodes = tinyAstNodes(file, &count);
+        CHECK(count == 11);
+        CHECK(nodes[0].nodekind == TINY_STMTK && nodes[0].kind == TINY_READK);
+        CHECK(!strcmp(tinyAstName(file, &nodes[0]), "x"));
+        CHECK(nodes[0].sibling == 1 && nodes[1].kind == TINY_REPEATK);
+        back = astTree(file);
+        CHECK(back != NULL && want != NULL && got != NULL);
+        if (back != NULL && want != NULL && got != NULL) {
+            printTree(want, tree);
+            printTree(got, back);
+            CHECK(sameText(want, got));
+        }
+        astFree(back);
+        tinyAstClose(file);
+    }
+
+    /* 同一节点被链接两次 */
+    patch(path, bad, 0, 0, 1);
+    CHECK(tinyAstOpen(bad) == NULL);
+    /* 节点没有被链接到 */
+    patch(path, bad, 0, MAXCHILDREN, 0);
+    CHECK(tinyAstOpen(bad) == NULL);
+    /* 链接向后之外的方向 */
+    patch(path, bad, 1, MAXCHILDREN, -1);
+    CHECK(tinyAstOpen(bad) == NULL);
+    remove(path);
+    remove(bad);
+    if (want != NULL)
+        fclose(want);
+    if (got != NULL)
+        fclose(got);
+    freeTree(tree);
+    testDeepAst(path);
+}
+
+/* testPool checks that equal string literals share the
+   index of their first appearance, including empty and
+   multi-line ones, as the table grows and after a
+   checkpoint is restored */
+/* testPool检查相同的字符串字面量共享首次出现时的编号，包括空字面量和跨行字面量，
+   以及表扩大后和恢复检查点后的情况 */
+static void testPool(void) {
+    static const char src[] = "'a' 'b' x 'a' '' 'multi\nline' '' 'b'";
+    static const int want[] = {0, 1, -1, 0, 2, 3, 2, 1};
+    char many[2048];
+    TinyCheckpoint cp;
+    TinyScanner *sc = open(src, TINY_STRING_POOL);
+    const char *text;
+    size_t len;
+    int n = 0;
+    int i;
+    for (i = 0; i < 8; i++) {
+        CHECK(tinyNextToken(sc) == (want[i] < 0 ? TINY_ID : TINY_STR));
+        CHECK(tinyTokenLiteral(sc) == want[i]);
+    }
+    CHECK(tinyNextToken(sc) == TINY_ENDFILE && tinyTokenLiteral(sc) == -1);
+    CHECK(tinyLiteralCount(sc) == 4);
+    text = tinyLiteral(sc, 0, &len);
+    CHECK(text != NULL && len == 1 && !strcmp(text, "a"));
+    text = tinyLiteral(sc, 2, &len);
+    CHECK(text != NULL && len == 0 && text[0] == '\0');
+    text = tinyLiteral(sc, 3, &len);
+    CHECK(text != NULL && len == 10 && !strcmp(text, "multi\nline"));
+    CHECK(tinyLiteral(sc, 4, &len) == NULL && tinyLiteral(sc, -1, &len) == NULL);
+    tinyClose(sc);
+
+    /* 未使用TINY_STRING_POOL时没有池 */
+    sc = open(src, 0);
+    CHECK(tinyNextToken(sc) == TINY_STR && tinyTokenLiteral(sc) == -1);
+    CHECK(tinyLiteralCount(sc) == 0 && tinyLiteral(sc, 0, &len) == NULL);
+    tinyClose(sc);
+
+    /* 100个字面量使表从16项扩大到256项，倒序再出现时编号不变 */
+    for (i = 0; i < 100; i++)
+        n += sprintf(many + n, "'l%d' ", i);
+    for (i = 99; i >= 0; i--)
+        n += sprintf(many + n, "'l%d' ", i);
+    sc = open(many, TINY_STRING_POOL);
+    for (i = 0; i < 200; i++) {
+        char lit[8];
+        int index = i < 100 ? i : 199 - i;
+        CHECK(tinyNextToken(sc) == TINY_STR && tinyTokenLiteral(sc) == index);
+        sprintf(lit, "l%d", index);
+        text = tinyLiteral(sc, index, &len);
+        CHECK(text != NULL && len == strlen(lit) && !strcmp(text, lit));
+    }
+    CHECK(tinyLiteralCount(sc) == 100);
+    tinyClose(sc);
+
+    /* 恢复检查点后再次扫描到的字面量保持原编号，池不缩小 */
+    sc = open("'x' 'y' 'z' 'y' 'w'", TINY_STRING_POOL);
+    tinyNextToken(sc);
+    tinyNextToken(sc);
+    tinySave(sc, &cp);
+    while (tinyNextToken(sc) != TINY_ENDFILE);
+    CHECK(tinyLiteralCount(sc) == 4);
+    tinyRestore(sc, &cp);
+    CHECK(tinyNextToken(sc) == TINY_STR && tinyTokenLiteral(sc) == 2);
+    CHECK(tinyNextToken(sc) == TINY_STR && tinyTokenLiteral(sc) == 1);
+    CHECK(tinyNextToken(sc) == TINY_STR && tinyTokenLiteral(sc) == 3);
+    CHECK(tinyLiteralCount(sc) == 4);
+    tinyClose(sc);
+}
+
+/* testLines checks offsets against lines and columns
+   counted by hand, the first and the last byte, and
+   sources with and without a final newline */
+/* testLines将偏移得到的行列号与逐字节数出的结果比较，包括第一个和最后一个字节，
+   以及有无结尾换行符的源程序 */
+static void testLines(void) {
+    static const char *const sources[] = {"", "x", "x\n", "ab\ncd\n\nlast", "\n\n", NULL};
+    char random[2048];
+    unsigned seed = 35;
+    int k;
+    for (k = 0; k < (int) sizeof(random) - 1; k++) {
+        seed = seed * 1103515245u + 12345u;
+        random[k] = (seed >> 16) % 5 == 0 ? '\n' : (char) ('a' + (seed >> 16) % 26);
+    }
+    random[k] = '\0';
+    for (k = 0; k < 6; k++) {
+        const char *src = sources[k] != NULL ? sources[k] : random;
+        size_t len = strlen(src);
+        TinyScanner *sc = open(src, 0);
+        const char *text;
+        size_t offset;
+        size_t start = 0; /* start of the line of offset */
+        size_t n;
+        int line = 1;
+        int l, c;
+        for (offset = 0; offset <= len; offset++) {
+            CHECK(tinyLocate(sc, offset, &l, &c) == 1);
+            CHECK(l == line && c == (int) (offset - start) + 1);
+            /* 每一行的文本到换行符或源程序末尾为止 */
+            if (offset == len || src[offset] == '\n') {
+                text = tinyLineText(sc, line, &n);
+                CHECK(text == src + start && n == offset - start);
+                line++;
+                start = offset + 1;
+            }
+        }
+        CHECK(tinyLocate(sc, len + 1, &l, &c) == 0);
+        CHECK(tinyLineText(sc, 0, &n) == NULL);
+        CHECK(tinyLineText(sc, line, &n) == NULL);
+        tinyClose(sc);
+    }
+}
+
+/* testNames checks names at the inline limit of
+   NAMEINLINE bytes and one and two bytes past it, and
+   comparisons between the two forms */
+/* testNames检查长度恰为NAMEINLINE以及超出1、2个字节的名字，
+   以及两种形式之间的比较 */
+static void testNames(void) {
+    static const char *const texts[] = {
+            "abcdefghijklmno", "abcdefghijklmnop", "abcdefghijklmnopq",
+            "abcdefghijklmnoq", "abcdefghijklmnx", "abcdefghijklmnopx", "abc"};
+    enum { COUNT = sizeof(texts) / sizeof(texts[0]) };
+    Name names[COUNT];
+    Name again;
+    int i, j;
+    for (i = 0; i < COUNT; i++) {
+        size_t n = strlen(texts[i]);
+        CHECK(nameSet(&names[i], texts[i]));
+        CHECK(!strcmp(nameText(&names[i]), texts[i]));
+        /* 恰为NAMEINLINE个字节的名字仍在内部，其后的NUL与tag是同一个字节 */
+        CHECK((names[i].ext.tag == NAMEEXTERNAL) == (n > NAMEINLINE));
+        if (n > NAMEINLINE)
+            CHECK(names[i].ext.len == n);
+        else
+            CHECK(names[i].inl[NAMEINLINE] == '\0');
+    }
+    for (i = 0; i < COUNT; i++) {
+        CHECK(nameSet(&again, texts[i]));
+        CHECK(nameEqual(&names[i], &again) && nameEqual(&again, &names[i]));
+        nameFree(&again);
+        for (j = 0; j < COUNT; j++)
+            if (j != i)
+                CHECK(!nameEqual(&names[i], &names[j]));
+    }
+    for (i = 0; i < COUNT; i++) {
+        nameFree(&names[i]);
+        CHECK(names[i].ext.tag == 0 && nameText(&names[i])[0] == '\0');
+    }
+}
+
+/* tests by the name given on the command line */
+/* 按命令行给出的名字选择测试 */
+static const struct {
+    const char *name;
+    void (*run)(void);
+} tests[] = {
+        {"tokens",      testTokens},
+        {"checkpoint",  testCheckpoint},
+        {"diagnostics", testDiagnostics},
+        {"echo",        testEcho},
+        {"chunks",      testChunks},
+        {"floats",      testFloats},
+        {"pool",        testPool},
+        {"lines",       testLines},
+        {"names",       testNames},
+        {"ast",         testAst}};
+
+int main(int argc, char *argv[]) {
+    size_t i;
+    int ran = 0;
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+        if (argc < 2 || !strcmp(argv[1], tests[i].name)) {
+            tests[i].run();
+            ran++;
+        }
+    if (ran == 0) {
+        fprintf(stderr, "usage: %s [test]\n", argv[0]);
+        return 2;
+    }
+    return failures > 0;
+}
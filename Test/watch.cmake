@@ -0,0 +1,38 @@
+# watch.cmake checks that TINY -watch lists each saved
+# version of a file as a fresh compile of it would; run
+# it with cmake -P, TINY and DIR set
+# 检查TINY -watch对文件每个保存的版本给出的列表与重新完整编译相同
+
+set(SRC ${DIR}/watched.tny)
+
+if (DEFINED LAST)
+    # 编辑者：等watch编译完上一个版本后保存下一个版本
+    foreach (v RANGE 2 ${LAST})
+        execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 1)
+        file(READ ${DIR}/watched.${v} text)
+        file(WRITE ${SRC} "${text}")
+    endforeach ()
+    return()
+endif ()
+
+# 版本1是tiny1.txt；版本2改动中间一行；版本3在末尾加上未闭合的字符串
+file(READ ${CMAKE_CURRENT_LIST_DIR}/tiny1.txt v1)
+string(REPLACE "2ab" "ab2 @" v2 "${v1}")
+set(v3 "${v2}\nx := 'open\n")
+set(want "")
+foreach (v 1 2 3)
+    file(WRITE ${DIR}/watched.${v} "${v${v}}")
+    file(WRITE ${SRC} "${v${v}}")
+    execute_process(COMMAND ${TINY} ${SRC} OUTPUT_VARIABLE fresh)
+    string(APPEND want "${fresh}")
+endforeach ()
+
+file(WRITE ${SRC} "${v1}")
+execute_process(COMMAND ${CMAKE_COMMAND} -DDIR=${DIR} -DLAST=3 -P ${CMAKE_CURRENT_LIST_FILE}
+        COMMAND ${TINY} -watch ${SRC}
+        OUTPUT_VARIABLE got TIMEOUT 4)
+if (NOT got STREQUAL want)
+    file(WRITE ${DIR}/watched.got "${got}")
+    file(WRITE ${DIR}/watched.want "${want}")
+    message(FATAL_ERROR "the -watch listing ${DIR}/watched.got differs from ${DIR}/watched.want")
+endif ()
@@ -0,0 +1,363 @@
+/****************************************************/
+/* File: ast.c                                      */
+/* Binary syntax tree file implementation           */
+/* 语法树二进制文件的实现                           */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "ast.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+struct TinyAstFile {
+    const char *base;   /* the whole file */
+    size_t size;
+    bool mapped;        /* base is a mapping, not a heap buffer */
+    const TinyAstNode *nodes;
+    uint32_t count;
+    const char *strings;
+};
+
+/* hasName tells whether attr of t is a name */
+/* hasName判断t的attr是否为名字 */
+static bool hasName(NodeKind nodekind, int kind) {
+    if (nodekind == StmtK)
+        return kind == AssignK || kind == ReadK;
+    return kind == IdK;
+}
+
+/* state of astWrite */
+/* astWrite的状态 */
+typedef struct {
+    TinyAstNode *nodes;
+    uint32_t next;      /* index of the next node */
+    char *strings;
+    uint32_t used;      /* bytes of the string table used */
+} Writer;
+
+/* a node waiting to be placed, with the link that
+   must be set to its index */
+/* 等待编号的节点，以及需要填入其下标的链接 */
+typedef struct {
+    TreeNode *tree;
+    uint32_t from;      /* index of the node linking to tree */
+    int32_t *link;      /* NULL for the root */
+} Pending;
+
+/* measure counts the nodes and name bytes of tree,
+   walking it with an explicit stack so that a deep tree
+   cannot overflow the C stack; it returns false when
+   out of memory */
+/* measure用显式栈遍历tree，统计其节点数和名字字节数，使很深的树不会耗尽C栈；
+   内存不足时返回false */
+static bool measure(TreeNode *tree, size_t *nodes, size_t *strings) {
+    TreeNode **stack = NULL;
+    size_t top = 0;
+    size_t size = 0;
+    int i;
+    if (tree == NULL)
+        return true;
+    do {
+        /* 每个节点最多压入一个兄弟和MAXCHILDREN个孩子 */
+        if (top + MAXCHILDREN + 1 > size) {
+            size_t grown = size ? size * 2 : 64;
+            TreeNode **more = (TreeNode **) realloc(stack, grown * sizeof(TreeNode *));
+            if (more == NULL) {
+                free(stack);
+                return false;
+            }
+            stack = more;
+            size = grown;
+        }
+        if (top > 0)
+            tree = stack[--top];
+        (*nodes)++;
+        if (hasName(tree->nodekind, tree->kind.stmt))
+            *strings += strlen(nameText(&tree->attr.name)) + 1;
+        if (tree->sibling != NULL)
+            stack[top++] = tree->sibling;
+        for (i = MAXCHILDREN - 1; i >= 0; i--)
+            if (tree->child[i] != NULL)
+                stack[top++] = tree->child[i];
+    } while (top > 0);
+    free(stack);
+    return true;
+}
+
+/* place numbers tree and its siblings in preorder and
+   fills in their records; stack has room for every
+   node, as each is pushed once, by the node linking
+   to it, and children are popped before the sibling */
+/* place按先序为tree及其兄弟编号并填写其记录；每个节点只由链接它的节点压入一次，
+   因此stack能容纳所有节点；孩子先于兄弟弹出 */
+static void place(Writer *w, TreeNode *tree, Pending *stack) {
+    size_t top = 0;
+    int i;
+    if (tree == NULL)
+        return;
+    stack[top].tree = tree;
+    stack[top].link = NULL;
+    top++;
+    while (top > 0) {
+        Pending p = stack[--top];
+        uint32_t idx = w->next++;
+        TinyAstNode *n = &w->nodes[idx];
+        tree = p.tree;
+        memset(n, 0, sizeof(TinyAstNode));
+        if (p.link != NULL)
+            *p.link = (int32_t) (idx - p.from);
+        n->lineno = tree->lineno;
+        n->nodekind = (uint8_t) tree->nodekind;
+        n->kind = (uint8_t) (tree->nodekind == StmtK ? (int) tree->kind.stmt : (int) tree->kind.exp);
+        n->type = (uint8_t) tree->type;
+        if (hasName(tree->nodekind, n->kind)) {
+            const char *s = nameText(&tree->attr.name);
+            size_t len = strlen(s) + 1;
+            n->attr = (int32_t) w->used;
+            memcpy(w->strings + w->used, s, len);
+            w->used += (uint32_t) len;
+        } else if (tree->nodekind == ExpK && tree->kind.exp == OpK)
+            n->attr = (int32_t) tree->attr.op;
+        else
+            n->attr = tree->attr.val;
+        if (tree->sibling != NULL) {
+            stack[top].tree = tree->sibling;
+            stack[top].from = idx;
+            stack[top].link = &n->sibling;
+            top++;
+        }
+        for (i = MAXCHILDREN - 1; i >= 0; i--)
+            if (tree->child[i] != NULL) {
+                stack[top].tree = tree->child[i];
+                stack[top].from = idx;
+                stack[top].link = &n->child[i];
+                top++;
+            }
+    }
+}
+
+bool astWrite(FILE *out, TreeNode *tree) {
+    AstHeader h;
+    Writer w;
+    Pending *stack;
+    size_t nodes = 0;
+    size_t strings = 0;
+    bool ok;
+    if (!measure(tree, &nodes, &strings) || nodes > INT32_MAX || strings > INT32_MAX)
+        return false;
+    w.nodes = (TinyAstNode *) malloc(nodes ? nodes * sizeof(TinyAstNode) : 1);
+    w.strings = (char *) malloc(strings ? strings : 1);
+    w.next = 0;
+    w.used = 0;
+    stack = (Pending *) malloc(nodes ? nodes * sizeof(Pending) : 1);
+    ok = w.nodes != NULL && w.strings != NULL && stack != NULL;
+    if (ok) {
+        place(&w, tree, stack);
+        memcpy(h.magic, AST_MAGIC, sizeof(h.magic));
+        h.order = AST_ORDER;
+        h.version = AST_VERSION;
+        h.nodes = (uint32_t) nodes;
+        h.strings = (uint32_t) strings;
+        ok = fwrite(&h, sizeof(h), 1, out) == 1
+             && fwrite(w.nodes, sizeof(TinyAstNode), nodes, out) == nodes
+             && fwrite(w.strings, 1, strings, out) == strings;
+    }
+    free(w.nodes);
+    free(w.strings);
+    free(stack);
+    return ok;
+}
+
+/* validLink checks a link of node i */
+/* validLink检查节点i的一个链接 */
+static bool validLink(int32_t rel, uint32_t i, uint32_t count) {
+    return rel == 0 || (rel > 0 && (uint32_t) rel < count - i);
+}
+
+/* check checks every node of file, so that the other
+   functions can trust it; links only point forward, so
+   nothing links to the root, and every other node must
+   be linked to exactly once, so the nodes form one tree */
+/* check检查file的每个节点，使其他函数可以信任它；链接只向后指，因此没有链接指向根，
+   其他每个节点必须恰好被链接一次，因此节点构成一棵树 */
+static bool check(TinyAstFile *file) {
+    const AstHeader *h = (const AstHeader *) file->base;
+    unsigned char *linked;
+    bool ok = true;
+    uint32_t i;
+    int c;
+    if (file->size < sizeof(AstHeader) || memcmp(h->magic, AST_MAGIC, sizeof(h->magic))
+        || h->order != AST_ORDER || h->version != AST_VERSION)
+        return false;
+    if ((file->size - sizeof(AstHeader)) / sizeof(TinyAstNode) < h->nodes
+        || file->size != sizeof(AstHeader) + (size_t) h->nodes * sizeof(TinyAstNode) + h->strings)
+        return false;
+    file->nodes = (const TinyAstNode *) (file->base + sizeof(AstHeader));
+    file->count = h->nodes;
+    file->strings = (const char *) (file->nodes + h->nodes);
+    if (h->strings > 0 && file->strings[h->strings - 1] != '\0')
+        return false;
+    /* 每个节点一位，记录它是否已被链接 */
+    linked = (unsigned char *) calloc(file->count / CHAR_BIT + 1, 1);
+    if (linked == NULL)
+        return false;
+    for (i = 0; i < file->count && ok; i++) {
+        const TinyAstNode *n = &file->nodes[i];
+        if (n->nodekind > ExpK || n->kind > (n->nodekind == StmtK ? WriteK : StrK) || n->type > Boolean)
+            ok = false;
+        for (c = 0; c <= MAXCHILDREN && ok; c++) {
+            int32_t rel = c < MAXCHILDREN ? n->child[c] : n->sibling;
+            uint32_t to = i + (uint32_t) rel;
+            if (!validLink(rel, i, file->count))
+                ok = false;
+            else if (rel != 0) {
+                if (linked[to / CHAR_BIT] & 1u << to % CHAR_BIT)
+                    ok = false;
+                linked[to / CHAR_BIT] |= (unsigned char) (1u << to % CHAR_BIT);
+            }
+        }
+        if (hasName((NodeKind) n->nodekind, n->kind) && (n->attr < 0 || (uint32_t) n->attr >= h->strings))
+            ok = false;
+    }
+    /* 根之外的节点都必须被链接到 */
+    for (i = 1; i < file->count && ok; i++)
+        if (!(linked[i / CHAR_BIT] & 1u << i % CHAR_BIT))
+            ok = false;
+    free(linked);
+    return ok;
+}
+
+TinyAstFile *tinyAstOpen(const char *path) {
+    TinyAstFile *file = (TinyAstFile *) calloc(1, sizeof(TinyAstFile));
+    if (file == NULL)
+        return NULL;
+#ifndef _WIN32
+    {
+        int fd = open(path, O_RDONLY);
+        struct stat sb;
+        if (fd >= 0 && fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+            void *map = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                file->base = (const char *) map;
+                file->size = (size_t) sb.st_size;
+                file->mapped = true;
+            }
+        }
+        if (fd >= 0)
+            close(fd);
+    }
+#endif
+    /* 无法映射时读入整个文件 */
+    if (file->base == NULL) {
+        FILE *f = fopen(path, "rb");
+        char *buf;
+        long size;
+        if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0
+            || (buf = (char *) malloc(size ? (size_t) size : 1)) == NULL) {
+            if (f != NULL)
+                fclose(f);
+            free(file);
+            return NULL;
+        }
+        file->size = fread(buf, 1, (size_t) size, f);
+        file->base = buf;
+        fclose(f);
+    }
+    if (!check(file)) {
+        tinyAstClose(file);
+        return NULL;
+    }
+    return file;
+}
+
+const TinyAstNode *tinyAstNodes(const TinyAstFile *file, uint32_t *count) {
+    *count = file->count;
+    return file->nodes;
+}
+
+const char *tinyAstName(const TinyAstFile *file, const TinyAstNode *node) {
+    return file->strings + node->attr;
+}
+
+/* freeNames frees the long names of a block made by
+   astTree; its nodes are in preorder and every node but
+   the first is linked from an earlier one, so the block
+   is walked in order up to the last node linked, with
+   no recursion and no stack */
+/* freeNames释放astTree所建内存块中的长名字；节点按先序排列，除第一个外都由
+   更前的节点链接，因此按顺序遍历到被链接的最后一个节点，无需递归和栈 */
+static void freeNames(TreeNode *block) {
+    TreeNode *t = block;
+    TreeNode *end = block + 1;
+    int i;
+    for (; t < end; t++) {
+        if (hasName(t->nodekind, t->kind.stmt))
+            nameFree(&t->attr.name);
+        for (i = 0; i < MAXCHILDREN; i++)
+            if (t->child[i] != NULL && t->child[i] >= end)
+                end = t->child[i] + 1;
+        if (t->sibling != NULL && t->sibling >= end)
+            end = t->sibling + 1;
+    }
+}
+
+TreeNode *astTree(const TinyAstFile *file) {
+    TreeNode *block;
+    uint32_t i;
+    int c;
+    if (file->count == 0)
+        return NULL;
+    /* 所有节点在一块内存中，根是第一个 */
+    block = (TreeNode *) calloc(file->count, sizeof(TreeNode));
+    if (block == NULL)
+        return NULL;
+    for (i = 0; i < file->count; i++) {
+        const TinyAstNode *n = &file->nodes[i];
+        TreeNode *t = &block[i];
+        for (c = 0; c < MAXCHILDREN; c++)
+            t->child[c] = n->child[c] ? t + n->child[c] : NULL;
+        t->sibling = n->sibling ? t + n->sibling : NULL;
+        t->lineno = n->lineno;
+        t->nodekind = (NodeKind) n->nodekind;
+        if (t->nodekind == StmtK)
+            t->kind.stmt = (StmtKind) n->kind;
+        else
+            t->kind.exp = (ExpKind) n->kind;
+        t->type = (ExpType) n->type;
+        if (hasName(t->nodekind, n->kind)) {
+            if (!nameSet(&t->attr.name, file->strings + n->attr)) {
+                /* 尚未转换的节点的名字为空，可以安全释放 */
+                astFree(block);
+                return NULL;
+            }
+        } else if (t->nodekind == ExpK && t->kind.exp == OpK)
+            t->attr.op = (TokenType) n->attr;
+        else
+            t->attr.val = n->attr;
+    }
+    return block;
+}
+
+void astFree(TreeNode *tree) {
+    if (tree != NULL)
+        freeNames(tree);
+    free(tree);
+}
+
+void tinyAstClose(TinyAstFile *file) {
+    if (file == NULL)
+        return;
+#ifndef _WIN32
+    if (file->mapped)
+        munmap((void *) file->base, file->size);
+    else
+#endif
+        free((void *) file->base);
+    free(file);
+}
@@ -0,0 +1,46 @@
+/****************************************************/
+/* File: ast.h                                      */
+/* Binary syntax tree files for the TINY compiler   */
+/* 语法树的二进制文件                               */
+/****************************************************/
+
+#ifndef _AST_H_
+#define _AST_H_
+
+#define AST_MAGIC "TINYAST1"
+#define AST_ORDER 0x01020304u /* reads differently in the other byte order */
+#define AST_VERSION 1
+
+/* an AST file is an AstHeader, then the TinyAstNode
+ * records in preorder with the root first, then the
+ * string table of NUL-terminated names; tiny.h has the
+ * reader
+ * AST文件由AstHeader、按先序排列（根在最前）的TinyAstNode记录以及以NUL结尾的名字串表组成；
+ * 读取函数在tiny.h中
+ */
+typedef struct {
+    char magic[8];     /* AST_MAGIC */
+    uint32_t order;    /* AST_ORDER in the byte order of the writer */
+    uint32_t version;  /* AST_VERSION */
+    uint32_t nodes;    /* number of TinyAstNode records */
+    uint32_t strings;  /* bytes in the string table */
+} AstHeader;
+
+/* Function astWrite writes tree to out as an AST
+ * file, returning false if it could not
+ * 函数astWrite将tree以AST文件格式写入out，失败时返回false
+ */
+bool astWrite(FILE *out, TreeNode *tree);
+
+/* Function astTree turns the nodes of file into a
+ * TreeNode tree in one pass, or returns NULL when out
+ * of memory; free it with astFree
+ * 函数astTree一遍将file的节点转换为TreeNode树，内存不足时返回NULL；用astFree释放
+ */
+TreeNode *astTree(const TinyAstFile *file);
+
+/* Procedure astFree frees a tree made by astTree */
+/* 过程astFree释放astTree生成的树 */
+void astFree(TreeNode *tree);
+
+#endif
@@ -0,0 +1,375 @@
+/****************************************************/
+/* File: cache.c                                    */
+/* Compilation result cache implementation          */
+/* 编译结果缓存的实现                               */
+/****************************************************/
+
+#include "globals.h"
+#include "cache.h"
+
+#ifndef _WIN32
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+/* CACHE_VERSION is hashed into every key so that
+   listings of an older format are never reused */
+/* CACHE_VERSION参与每个key的计算，旧格式的列表不会被复用 */
+#define CACHE_VERSION 2
+
+/* CACHEPATHLEN = longest path of a cache file */
+/* CACHEPATHLEN =缓存文件路径的最大长度 */
+#define CACHEPATHLEN 4096
+
+/* path of the temporary file opened by cacheBegin */
+/* cacheBegin打开的临时文件路径 */
+static char tmpPath[CACHEPATHLEN];
+
+/*****************  XXH64 hash  *****************/
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t read64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t read32(const char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t xxhRound(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static uint64_t xxhMerge(uint64_t acc, uint64_t val) {
+    acc ^= xxhRound(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+/* xxh64 hashes len bytes of p (little-endian XXH64) */
+/* xxh64计算p中len个字节的XXH64哈希 */
+static uint64_t xxh64(const char *p, size_t len, uint64_t seed) {
+    const char *end = p + len;
+    uint64_t h;
+    if (len >= 32) {
+        const char *limit = end - 32;
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        do {
+            v1 = xxhRound(v1, read64(p));
+            v2 = xxhRound(v2, read64(p + 8));
+            v3 = xxhRound(v3, read64(p + 16));
+            v4 = xxhRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxhMerge(h, v1);
+        h = xxhMerge(h, v2);
+        h = xxhMerge(h, v3);
+        h = xxhMerge(h, v4);
+    } else
+        h = seed + PRIME64_5;
+    h += (uint64_t) len;
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxhRound(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t) read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= (uint64_t) (unsigned char) *p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+    }
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t cacheKey(const char *src, size_t len, const char *name, int limit, unsigned flags) {
+    uint64_t seed = ((uint64_t) CACHE_VERSION << 32) | flags;
+    seed = xxh64((const char *) &limit, sizeof(limit), seed);
+    if (name != NULL)
+        seed = xxh64(name, strlen(name), seed);
+    return xxh64(src, len, seed);
+}
+
+/*****************  cache files  *****************/
+
+static void entryPath(char *path, const char *dir, uint64_t key) {
+    snprintf(path, CACHEPATHLEN, "%s/%016llx.lst", dir, (unsigned long long) key);
+}
+
+/* copyFile copies the rest of in to out */
+/* copyFile将in的剩余内容复制到out */
+static void copyFile(FILE *in, FILE *out) {
+    char buf[8192];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+        fwrite(buf, 1, n, out);
+}
+
+/* statistics kept in <dir>/stats */
+/* 保存在<dir>/stats中的统计信息 */
+typedef struct {
+    long hits;
+    long misses;
+    long bytes;
+} CacheStats;
+
+static void readStats(const char *dir, CacheStats *st) {
+    char path[CACHEPATHLEN];
+    FILE *f;
+    st->hits = st->misses = st->bytes = 0;
+    snprintf(path, sizeof(path), "%s/stats", dir);
+    f = fopen(path, "r");
+    if (f == NULL)
+        return;
+    if (fscanf(f, "hits %ld misses %ld bytes %ld", &st->hits, &st->misses, &st->bytes) != 3)
+        st->hits = st->misses = st->bytes = 0;
+    fclose(f);
+}
+
+/* writeStats replaces the stats file with a rename so
+   that a concurrent reader never sees it half written */
+/* writeStats通过rename替换统计文件，并发读取时不会看到写了一半的文件 */
+static void writeStats(const char *dir, const CacheStats *st) {
+    char path[CACHEPATHLEN];
+    char tmp[CACHEPATHLEN];
+    FILE *f;
+    snprintf(path, sizeof(path), "%s/stats", dir);
+    snprintf(tmp, sizeof(tmp), "%s/stats.%ld", dir, (long) getpid());
+    f = fopen(tmp, "w");
+    if (f == NULL)
+        return;
+    fprintf(f, "hits %ld\nmisses %ld\nbytes %ld\n", st->hits, st->misses, st->bytes);
+    fclose(f);
+    rename(tmp, path);
+}
+
+/* lockStats takes the lock that serializes updates of
+   the stats file between processes, and returns its
+   descriptor, or -1 if it cannot be taken; the lock is
+   on a file of its own since writeStats replaces stats */
+/* lockStats获取在进程之间串行化统计文件更新的锁，返回其描述符，无法获取时返回-1；
+   由于writeStats会替换stats，锁加在单独的文件上 */
+static int lockStats(const char *dir) {
+    char path[CACHEPATHLEN];
+    int fd;
+    snprintf(path, sizeof(path), "%s/stats.lock", dir);
+    fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (fd < 0)
+        return -1;
+    while (flock(fd, LOCK_EX) < 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+/* unlockStats releases the lock taken by lockStats */
+/* unlockStats释放lockStats获取的锁 */
+static void unlockStats(int fd) {
+    if (fd >= 0)
+        close(fd);
+}
+
+/* countLookup adds a hit or a miss to the stats */
+/* countLookup在统计信息中增加一次命中或未命中 */
+static void countLookup(const char *dir, bool hit) {
+    CacheStats st;
+    int lock = lockStats(dir);
+    readStats(dir, &st);
+    if (hit)
+        st.hits++;
+    else
+        st.misses++;
+    writeStats(dir, &st);
+    unlockStats(lock);
+}
+
+bool cacheLookup(const char *dir, uint64_t key, FILE *out) {
+    char path[CACHEPATHLEN];
+    FILE *f;
+    mkdir(dir, 0777);
+    entryPath(path, dir, key);
+    f = fopen(path, "r");
+    if (f == NULL) {
+        countLookup(dir, false);
+        return false;
+    }
+    copyFile(f, out);
+    fclose(f);
+    /* 更新访问时间，供LRU淘汰使用 */
+    utime(path, NULL);
+    countLookup(dir, true);
+    return true;
+}
+
+FILE *cacheBegin(const char *dir) {
+    int fd;
+    FILE *f;
+    snprintf(tmpPath, sizeof(tmpPath), "%s/tmp.XXXXXX", dir);
+    fd = mkstemp(tmpPath);
+    if (fd < 0)
+        return NULL;
+    f = fdopen(fd, "w+");
+    if (f == NULL) {
+        close(fd);
+        unlink(tmpPath);
+    }
+    return f;
+}
+
+/* an entry considered for eviction */
+/* 待淘汰的条目 */
+typedef struct {
+    char name[32];
+    time_t mtime;
+    long size;
+} CacheEntry;
+
+static int olderFirst(const void *a, const void *b) {
+    time_t ta = ((const CacheEntry *) a)->mtime;
+    time_t tb = ((const CacheEntry *) b)->mtime;
+    return (ta > tb) - (ta < tb);
+}
+
+/* evict removes the least recently used listings until
+   the cache fits in limit bytes, returns the new size */
+/* evict删除最近最少使用的列表直到缓存不超过limit字节，返回新的大小 */
+static long evict(const char *dir, long limit) {
+    char path[CACHEPATHLEN];
+    CacheEntry *entries = NULL;
+    int count = 0;
+    int cap = 0;
+    long total = 0;
+    int i;
+    struct dirent *d;
+    struct stat sb;
+    DIR *dp = opendir(dir);
+    if (dp == NULL)
+        return 0;
+    while ((d = readdir(dp)) != NULL) {
+        size_t n = strlen(d->d_name);
+        if (n < 5 || n >= sizeof(entries->name) || strcmp(d->d_name + n - 4, ".lst") != 0)
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, d->d_name);
+        if (stat(path, &sb) < 0)
+            continue;
+        if (count == cap) {
+            CacheEntry *t;
+            cap = cap ? 2 * cap : 64;
+            t = (CacheEntry *) realloc(entries, cap * sizeof(CacheEntry));
+            if (t == NULL)
+                break;
+            entries = t;
+        }
+        strcpy(entries[count].name, d->d_name);
+        entries[count].mtime = sb.st_mtime;
+        entries[count].size = (long) sb.st_size;
+        total += entries[count].size;
+        count++;
+    }
+    closedir(dp);
+    qsort(entries, count, sizeof(CacheEntry), olderFirst);
+    for (i = 0; i < count && total > limit; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+        if (unlink(path) == 0)
+            total -= entries[i].size;
+    }
+    free(entries);
+    return total;
+}
+
+void cacheCommit(const char *dir, uint64_t key, FILE *tmp, FILE *out, long limit) {
+    char path[CACHEPATHLEN];
+    CacheStats st;
+    long size;
+    int lock;
+    fflush(tmp);
+    size = ftell(tmp);
+    rewind(tmp);
+    copyFile(tmp, out);
+    if (ferror(tmp)) {
+        fclose(tmp);
+        unlink(tmpPath);
+        return;
+    }
+    fclose(tmp);
+    entryPath(path, dir, key);
+    if (rename(tmpPath, path) < 0) {
+        unlink(tmpPath);
+        return;
+    }
+    lock = lockStats(dir);
+    readStats(dir, &st);
+    st.bytes += size;
+    if (st.bytes > limit)
+        st.bytes = evict(dir, limit);
+    writeStats(dir, &st);
+    unlockStats(lock);
+}
+
+void cachePrintStats(const char *dir, FILE *out) {
+    CacheStats st;
+    long lookups;
+    readStats(dir, &st);
+    lookups = st.hits + st.misses;
+    fprintf(out, "cache: %s\n", dir);
+    fprintf(out, "hits: %ld\nmisses: %ld\n", st.hits, st.misses);
+    fprintf(out, "hit rate: %.1f%%\n", lookups ? 100.0 * st.hits / lookups : 0.0);
+    fprintf(out, "size: %ld bytes\n", st.bytes);
+}
+
+#else
+
+uint64_t cacheKey(const char *src, size_t len, const char *name, int limit, unsigned flags) {
+    return 0;
+}
+
+bool cacheLookup(const char *dir, uint64_t key, FILE *out) {
+    return false;
+}
+
+FILE *cacheBegin(const char *dir) {
+    return NULL;
+}
+
+void cacheCommit(const char *dir, uint64_t key, FILE *tmp, FILE *out, long limit) {
+}
+
+void cachePrintStats(const char *dir, FILE *out) {
+    fprintf(out, "The result cache is not supported on this platform\n");
+}
+
+#endif
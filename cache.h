@@ -0,0 +1,60 @@
+/****************************************************/
+/* File: cache.h                                    */
+/* Compilation result cache for the TINY compiler   */
+/* 编译结果缓存                                     */
+/****************************************************/
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+/* CACHE_ENV names the environment variable holding the
+ * cache directory; caching is off when it is not set
+ * CACHE_ENV是保存缓存目录的环境变量，未设置时不使用缓存
+ */
+#define CACHE_ENV "TINY_CACHE"
+
+/* CACHE_SIZE_ENV optionally bounds the cache size in bytes
+ * CACHE_SIZE_ENV可选地限制缓存大小（字节）
+ */
+#define CACHE_SIZE_ENV "TINY_CACHE_SIZE"
+
+/* default bound on the total size of cached listings */
+/* 缓存列表总大小的默认上限 */
+#define CACHE_DEFAULT_SIZE (64L * 1024 * 1024)
+
+/* Function cacheKey hashes the source text together
+ * with the flags that change the listing, the error
+ * limit, and name unless it is NULL, for listings
+ * that show it
+ * 函数cacheKey将源程序文本与影响列表的标志和错误上限一起哈希；name不为NULL时也一起哈希，
+ * 用于包含文件名的列表
+ */
+uint64_t cacheKey(const char *src, size_t len, const char *name, int limit, unsigned flags);
+
+/* Function cacheLookup copies the listing cached under
+ * key to out and returns true, or returns false on a miss
+ * 函数cacheLookup命中时将key对应的列表复制到out并返回true，未命中返回false
+ */
+bool cacheLookup(const char *dir, uint64_t key, FILE *out);
+
+/* Function cacheBegin opens a temporary file in dir
+ * that the listing for a miss is written to
+ * 函数cacheBegin在dir中打开一个临时文件，未命中时列表写入其中
+ */
+FILE *cacheBegin(const char *dir);
+
+/* Function cacheCommit copies the listing in tmp to out,
+ * stores it under key and evicts the least recently
+ * used entries until the cache fits in limit bytes
+ * 函数cacheCommit将tmp中的列表复制到out，以key保存，
+ * 并淘汰最近最少使用的条目直到缓存不超过limit字节
+ */
+void cacheCommit(const char *dir, uint64_t key, FILE *tmp, FILE *out, long limit);
+
+/* Function cachePrintStats prints the hit/miss counts
+ * and the size of the cache in dir
+ * 函数cachePrintStats打印dir中缓存的命中/未命中次数和大小
+ */
+void cachePrintStats(const char *dir, FILE *out);
+
+#endif
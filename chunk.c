@@ -0,0 +1,136 @@
+/****************************************************/
+/* File: chunk.c                                    */
+/* Chunked scanning of one source on many threads   */
+/* 在多个线程上分块扫描一个源程序                   */
+/****************************************************/
+
+#include "globals.h"
+#include "scan.h"
+
+/* contexts a byte of the source can be scanned in */
+/* 扫描源程序字节时所处的上下文 */
+enum {
+    CTX_CODE,
+    CTX_COMMENT,
+    CTX_STRING,
+    CONTEXTS
+};
+
+/* the only bytes that change a context or count a line;
+   in code every other byte either belongs to a token or
+   is given back before '{' and '\'' are read at START */
+/* 只有这些字节会改变上下文或计入行数；在代码中其他字节或属于token，
+   或在START读到'{'和'\''之前被退回 */
+static const unsigned char special[256] = {['\n'] = 1, ['{'] = 1, ['}'] = 1, ['\''] = 1};
+
+/* nextContext gives the context after c is read in ctx */
+/* nextContext给出在ctx中读入c之后的上下文 */
+static int nextContext(int ctx, int c) {
+    switch (ctx) {
+        case CTX_CODE:
+            return c == '{' ? CTX_COMMENT : c == '\'' ? CTX_STRING : CTX_CODE;
+        case CTX_COMMENT:
+            return c == '}' ? CTX_CODE : CTX_COMMENT;
+        default:
+            return c == '\'' ? CTX_CODE : CTX_STRING;
+    }
+}
+
+void tinyChunkSplit(const char *buf, size_t len, TinyChunk *chunks, int count) {
+    size_t prev = 0;
+    int i;
+    for (i = 0; i < count; i++) {
+        size_t p = len / (size_t) count * (size_t) i;
+        const char *nl;
+        /* 块从行首开始 */
+        if (p < prev)
+            p = prev;
+        else if (p > 0 && buf[p - 1] != '\n') {
+            nl = memchr(buf + p, '\n', len - p);
+            p = nl != NULL ? (size_t) (nl - buf) + 1 : len;
+        }
+        chunks[i].begin = p;
+        if (i > 0)
+            chunks[i - 1].end = p;
+        prev = p;
+    }
+    if (count > 0)
+        chunks[count - 1].end = len;
+}
+
+void tinyChunkScan(const char *buf, TinyChunk *chunk) {
+    const unsigned char *p = (const unsigned char *) buf + chunk->begin;
+    const unsigned char *end = (const unsigned char *) buf + chunk->end;
+    int ctx[CONTEXTS];
+    int found = 0; /* contexts whose resume is known */
+    int k;
+    chunk->newlines = 0;
+    for (k = 0; k < CONTEXTS; k++) {
+        ctx[k] = k;
+        chunk->resume[k] = chunk->end;
+        chunk->lines[k] = 0;
+    }
+    /* 块从行首开始，以代码开始的块从begin恢复 */
+    if (p < end) {
+        chunk->resume[CTX_CODE] = chunk->begin;
+        found = 1 << CTX_CODE;
+    }
+    /* 三种可能的开始上下文同时推进 */
+    for (;;) {
+        while (p < end && !special[*p])
+            p++;
+        if (p == end)
+            break;
+        for (k = 0; k < CONTEXTS; k++)
+            ctx[k] = nextContext(ctx[k], *p);
+        if (*p++ == '\n') {
+            chunk->newlines++;
+            for (k = 0; k < CONTEXTS; k++)
+                if (ctx[k] == CTX_CODE && !(found & 1 << k) && p < end) {
+                    chunk->resume[k] = (size_t) (p - (const unsigned char *) buf);
+                    chunk->lines[k] = chunk->newlines;
+                    found |= 1 << k;
+                }
+        }
+    }
+    for (k = 0; k < CONTEXTS; k++)
+        chunk->exit[k] = (unsigned char) ctx[k];
+}
+
+void tinyChunkLink(TinyChunk *chunks, int count) {
+    int ctx = CTX_CODE;
+    int lines = 0;
+    int prev = -1; /* last chunk with tokens of its own */
+    int i;
+    for (i = 0; i < count; i++) {
+        TinyChunk *c = &chunks[i];
+        /* 没有处于代码中的行首时，字节属于前一个块 */
+        if (i == 0 || c->resume[ctx] < c->end) {
+            c->start = i == 0 ? 0 : c->resume[ctx];
+            c->line = i == 0 ? 0 : lines + c->lines[ctx];
+            if (prev >= 0)
+                chunks[prev].stop = c->start;
+            prev = i;
+        } else
+            c->start = c->stop = c->end;
+        c->last = false;
+        lines += c->newlines;
+        ctx = c->exit[ctx];
+    }
+    if (prev >= 0) {
+        chunks[prev].stop = chunks[count - 1].end;
+        chunks[prev].last = true;
+    }
+}
+
+TinyScanner *tinyOpenChunk(const char *buf, const TinyChunk *chunk, unsigned flags, FILE *listing) {
+    TinyScanner *sc = tinyOpenBuffer(buf, chunk->stop, flags, listing);
+    if (sc == NULL)
+        return NULL;
+    /* 行首处于代码中，此前的token都已结束 */
+    sc->pos = chunk->start;
+    sc->lineEnd = chunk->start;
+    sc->lineno = chunk->line;
+    sc->partial = !chunk->last;
+    return sc;
+}
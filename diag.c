@@ -0,0 +1,261 @@
+/****************************************************/
+/* File: diag.c                                     */
+/* Diagnostic collection and rendering              */
+/* 诊断的收集和输出                                 */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "diag.h"
+
+/* SNIPPET = most source bytes quoted by a diagnostic */
+/* SNIPPET =一个诊断引用的最多源程序字节数 */
+#define SNIPPET 40
+
+struct Diagnostics {
+    TinyDiagnostic *items;
+    int count;
+    int cap;
+    int limit;      /* stop after this many, 0 for no limit */
+    bool merge;     /* the last token was an invalid character */
+    bool stopped;
+};
+
+Diagnostics *diagNew(void) {
+    Diagnostics *d = (Diagnostics *) calloc(1, sizeof(Diagnostics));
+    if (d != NULL)
+        countAlloc(ALLOC_SCANNER, sizeof(Diagnostics));
+    return d;
+}
+
+/* add appends a diagnostic, dropping it when out of
+   memory; the error count still includes it */
+/* add追加一个诊断，内存不足时丢弃；错误数中仍计入它 */
+static void add(Diagnostics *d, TinyDiagCode code, int line, int endLine, size_t offset, size_t length) {
+    TinyDiagnostic *item;
+    if (d->count == d->cap) {
+        int cap = d->cap ? 2 * d->cap : 16;
+        TinyDiagnostic *t = (TinyDiagnostic *) realloc(d->items, (size_t) cap * sizeof(TinyDiagnostic));
+        if (t == NULL)
+            return;
+        countAlloc(ALLOC_SCANNER, (size_t) cap * sizeof(TinyDiagnostic));
+        d->items = t;
+        d->cap = cap;
+    }
+    item = &d->items[d->count++];
+    item->code = code;
+    item->line = line;
+    item->endLine = endLine;
+    item->offset = offset;
+    item->length = length;
+    item->count = 1;
+}
+
+void diagnose(TinyScanner *sc, TokenType token) {
+    Diagnostics *d = sc->diags;
+    bool merge = d->merge;
+    size_t length = sc->pos - sc->tokenStart;
+    d->merge = false;
+    switch (token) {
+        case ERROR:
+            /* 相邻的非法字符合并为一个诊断 */
+            if (sc->errorCode == TINY_DIAG_CHAR && merge && d->items[d->count - 1].line == sc->lineno) {
+                TinyDiagnostic *last = &d->items[d->count - 1];
+                last->length = sc->pos - last->offset;
+                last->count++;
+                d->merge = true;
+                return;
+            }
+            add(d, (TinyDiagCode) sc->errorCode, sc->lineno, sc->lineno, sc->tokenStart, length);
+            d->merge = sc->errorCode == TINY_DIAG_CHAR && d->count > 0
+                       && d->items[d->count - 1].offset == sc->tokenStart;
+            break;
+        case NUM:
+        case FNUM:
+            if (sc->NumOverflow)
+                add(d, TINY_DIAG_OVERFLOW, sc->lineno, sc->lineno, sc->tokenStart, length);
+            break;
+        case STR:
+            if (sc->StringStraddle)
+                add(d, TINY_DIAG_STRADDLE, sc->StringLine, sc->lineno, sc->tokenStart, length);
+            break;
+        case ENDFILE:
+            if (!sc->StringOver)
+                add(d, TINY_DIAG_OPEN_STRING, sc->StringLine, sc->lineno, sc->tokenStart, sc->len - sc->tokenStart);
+            if (sc->StringStraddle)
+                add(d, TINY_DIAG_STRADDLE, sc->StringLine, sc->lineno, sc->tokenStart, sc->len - sc->tokenStart);
+            if (!sc->CommentOver)
+                add(d, TINY_DIAG_OPEN_COMMENT, sc->CommentLine, sc->lineno, sc->tokenStart, sc->len - sc->tokenStart);
+            return;
+        default:
+            return;
+    }
+    /* 达到上限后跳到源程序末尾，下一个token为ENDFILE */
+    if (d->limit > 0 && d->count >= d->limit && !d->stopped) {
+        add(d, TINY_DIAG_LIMIT, sc->lineno, sc->lineno, sc->pos, 0);
+        d->stopped = true;
+        d->merge = false;
+        sc->pos = sc->len;
+        sc->lineEnd = sc->len;
+    }
+}
+
+void diagSave(const Diagnostics *diags, TinyCheckpoint *checkpoint) {
+    checkpoint->diags = diags->count;
+    /* 最后一个诊断还可能合并后续字符时，记下它已合并的错误数 */
+    checkpoint->merged = diags->merge ? diags->items[diags->count - 1].count : 0;
+    checkpoint->stopped = diags->stopped;
+}
+
+void diagRestore(Diagnostics *diags, const TinyCheckpoint *checkpoint) {
+    if (checkpoint->diags < diags->count)
+        diags->count = checkpoint->diags;
+    /* 在另一个扫描器上恢复时，保存之前的诊断不在本集合中，没有可以合并的诊断 */
+    diags->merge = checkpoint->merged > 0 && diags->count == checkpoint->diags;
+    diags->stopped = checkpoint->stopped != 0;
+    /* 撤回保存之后合并进最后一个诊断的字符，它当时止于pos */
+    if (diags->merge) {
+        TinyDiagnostic *last = &diags->items[diags->count - 1];
+        last->count = checkpoint->merged;
+        last->length = checkpoint->pos - last->offset;
+    }
+}
+
+void diagFree(Diagnostics *diags) {
+    if (diags != NULL) {
+        free(diags->items);
+        free(diags);
+    }
+}
+
+void tinySetErrorLimit(TinyScanner *scanner, int limit) {
+    if (scanner->diags != NULL)
+        scanner->diags->limit = limit > 0 ? limit : 0;
+}
+
+const TinyDiagnostic *tinyDiagnostics(const TinyScanner *scanner, int *count) {
+    *count = scanner->diags != NULL ? scanner->diags->count : 0;
+    return scanner->diags != NULL ? scanner->diags->items : NULL;
+}
+
+/* codeName gives the JSON name of each kind */
+/* codeName给出每种诊断的JSON名字 */
+static const char *codeName[] = {
+        "invalid-character", "bad-assign", "bad-exponent", "bad-number", "number-overflow",
+        "string-straddle", "open-string", "open-comment", "error-limit"};
+
+/* message writes the message of diagnostic g, without
+   the quoted source */
+/* message写出诊断g的消息，不含引用的源程序 */
+static void message(FILE *out, const TinyDiagnostic *g) {
+    switch (g->code) {
+        case TINY_DIAG_CHAR:
+            if (g->count > 1)
+                fprintf(out, "%d invalid characters", g->count);
+            else
+                fprintf(out, "invalid character");
+            break;
+        case TINY_DIAG_ASSIGN:
+            fprintf(out, "':' not followed by '='");
+            break;
+        case TINY_DIAG_EXPONENT:
+            fprintf(out, "exponent without digits");
+            break;
+        case TINY_DIAG_SEPARATE:
+            fprintf(out, "number run into letters");
+            break;
+        case TINY_DIAG_OVERFLOW:
+            fprintf(out, "number out of range");
+            break;
+        case TINY_DIAG_STRADDLE:
+            fprintf(out, "string straddles lines %d to %d", g->line, g->endLine);
+            break;
+        case TINY_DIAG_OPEN_STRING:
+            fprintf(out, "string right quote missing");
+            break;
+        case TINY_DIAG_OPEN_COMMENT:
+            fprintf(out, "comment right brace missing");
+            break;
+        case TINY_DIAG_LIMIT:
+            fprintf(out, "too many errors, scanning stopped");
+            break;
+    }
+}
+
+/* quotes tells whether a diagnostic quotes its source */
+/* quotes判断诊断是否引用其源程序 */
+static bool quotes(const TinyDiagnostic *g) {
+    return g->code <= TINY_DIAG_OVERFLOW;
+}
+
+/* jsonString writes the len bytes at s as a JSON
+   string */
+/* jsonString将s处的len个字节写成JSON字符串 */
+static void jsonString(FILE *out, const char *s, size_t len) {
+    size_t i;
+    fputc('"', out);
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char) s[i];
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20 || c >= 0x7F)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+/* columnOf gives the column of offset by scanning back
+   to the start of its line, so that printing a few
+   diagnostics does not index every line of the source */
+/* columnOf向前扫描到offset所在行的行首得到列号，使输出少量诊断时无需为源程序的每一行建立索引 */
+static int columnOf(const TinyScanner *sc, size_t offset) {
+    const char *start = sc->buf;
+    const char *p = sc->buf + offset;
+    while (p > start && p[-1] != '\n')
+        p--;
+    return (int) (sc->buf + offset - p) + 1;
+}
+
+void tinyPrintDiagnostics(TinyScanner *scanner, const char *name, FILE *out, int json) {
+    const TinyDiagnostic *g;
+    int count;
+    int i;
+    g = tinyDiagnostics(scanner, &count);
+    if (json) {
+        fprintf(out, "{\"file\": ");
+        jsonString(out, name, strlen(name));
+        fprintf(out, ", \"errors\": %d, \"diagnostics\": [", tinyErrorCount(scanner));
+    }
+    for (i = 0; i < count; i++, g++) {
+        const char *src = scanner->buf + g->offset;
+        size_t n = g->length < SNIPPET ? g->length : SNIPPET;
+        int line = g->line;
+        int column = columnOf(scanner, g->offset);
+        if (json) {
+            fprintf(out, "%s{\"code\": \"%s\", \"line\": %d, \"column\": %d, \"end_line\": %d, "
+                         "\"offset\": %lu, \"length\": %lu, \"count\": %d, \"message\": \"",
+                    i ? ", " : "", codeName[g->code], line, column, g->endLine,
+                    (unsigned long) g->offset, (unsigned long) g->length, g->count);
+            message(out, g);
+            fprintf(out, "\"");
+            if (quotes(g)) {
+                fprintf(out, ", \"source\": ");
+                jsonString(out, src, n);
+            }
+            fprintf(out, "}");
+        } else {
+            fprintf(out, "%s:%d:%d: error: ", name, line, column);
+            message(out, g);
+            if (quotes(g))
+                fprintf(out, " '%.*s'%s", (int) n, src, n < g->length ? "..." : "");
+            fprintf(out, "\n");
+        }
+    }
+    if (json)
+        fprintf(out, "]}\n");
+    else if (tinyErrorCount(scanner) > 0)
+        fprintf(out, "%d error%s\n", tinyErrorCount(scanner), tinyErrorCount(scanner) == 1 ? "" : "s");
+}
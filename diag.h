@@ -0,0 +1,39 @@
+/****************************************************/
+/* File: diag.h                                     */
+/* Diagnostic collection for the TINY scanner       */
+/* 扫描器的诊断收集                                 */
+/****************************************************/
+
+#ifndef _DIAG_H_
+#define _DIAG_H_
+
+/* Function diagNew returns an empty collection, or
+ * NULL when out of memory
+ * 函数diagNew返回一个空的诊断集合，内存不足时返回NULL
+ */
+Diagnostics *diagNew(void);
+
+/* Procedure diagnose records the errors found while
+ * scanning token
+ * 过程diagnose记录扫描token时发现的错误
+ */
+void diagnose(TinyScanner *sc, TokenType token);
+
+/* Procedure diagSave stores in checkpoint what
+ * diagRestore needs to drop the diagnostics collected
+ * after it
+ * 过程diagSave在checkpoint中保存diagRestore丢弃此后收集的诊断所需的信息
+ */
+void diagSave(const Diagnostics *diags, TinyCheckpoint *checkpoint);
+
+/* Procedure diagRestore returns the collection to the
+ * state saved in checkpoint
+ * 过程diagRestore将诊断集合恢复到checkpoint中保存的状态
+ */
+void diagRestore(Diagnostics *diags, const TinyCheckpoint *checkpoint);
+
+/* Procedure diagFree frees the collection */
+/* 过程diagFree释放诊断集合 */
+void diagFree(Diagnostics *diags);
+
+#endif
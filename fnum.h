@@ -0,0 +1,20 @@
+/****************************************************/
+/* File: fnum.h                                     */
+/* Decimal to double conversion for FNUM tokens     */
+/* FNUM token的十进制到double转换                   */
+/****************************************************/
+
+#ifndef _FNUM_H_
+#define _FNUM_H_
+
+/* Function floatValue converts the FNUM lexeme at s
+ * (digits, an optional fraction and an optional
+ * exponent) to the nearest double in val, and returns
+ * false if the value overflows; the result does not
+ * depend on the locale
+ * 函数floatValue将s处的FNUM词素（数字、可选的小数和指数部分）
+ * 转换为最接近的double存入val，溢出时返回false；结果与locale无关
+ */
+bool floatValue(const char *s, double *val);
+
+#endif
@@ -11,9 +11,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <ctype.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <float.h>
 
 //#ifndef FALSE
 //#define FALSE 0
@@ -27,90 +31,145 @@
 /* 保留字/关键字的数量 */
 #define MAXRESERVED 20
 
+#include "tiny.h"
+
 /* typedef 为类型取一个新的名字 */
 /* enum 枚举 */
 /* typedef enum 用typedef关键字将枚举类型定义成别名，并利用该别名进行变量声明 */
+/* TokenType mirrors TinyTokenType of the public interface */
+/* TokenType与公共接口中的TinyTokenType一一对应 */
 typedef enum
 /* book-keeping tokens */
 {
-    ENDFILE,
-    ERROR,
+    ENDFILE = TINY_ENDFILE,
+    ERROR = TINY_ERROR,
     /* reserved words */
-    IF,THEN,ELSE,END,REPEAT,UNTIL,READ,WRITE,
-    TRUE,FALSE,OR,AND,NOT,INT,BOOL,STRING,FLOAT,DOUBLE,DO,WHILE,
+    IF = TINY_IF, THEN = TINY_THEN, ELSE = TINY_ELSE, END = TINY_END,
+    REPEAT = TINY_REPEAT, UNTIL = TINY_UNTIL, READ = TINY_READ, WRITE = TINY_WRITE,
+    TRUE = TINY_TRUE, FALSE = TINY_FALSE, OR = TINY_OR, AND = TINY_AND, NOT = TINY_NOT,
+    INT = TINY_INT, BOOL = TINY_BOOL, STRING = TINY_STRING, FLOAT = TINY_FLOAT,
+    DOUBLE = TINY_DOUBLE, DO = TINY_DO, WHILE = TINY_WHILE,
     /* multicharacter tokens */
-    ID,
-    NUM,
-    STR,
+    ID = TINY_ID,
+    NUM = TINY_NUM,
+    FNUM = TINY_FNUM,
+    STR = TINY_STR,
     /* special symbols */
-    ASSIGN,    /* := */
-    EQ,        /* = */
-    LT,        /* < */
-    PLUS,      /* + */
-    MINUS,     /* - */
-    TIMES,     /* * */
-    OVER,      /* / */
-    LPAREN,    /* ( */
-    RPAREN,    /* ) */
-    SEMI,      /* ; */
-    MT,        /* > */
-    LE,        /* <= */
-    ME,        /* >= */
-    COMMA,     /* , */
-    QUOTATION, /* ' */
-    PERCENT    /* % */
+    ASSIGN = TINY_ASSIGN,       /* := */
+    EQ = TINY_EQ,               /* = */
+    LT = TINY_LT,               /* < */
+    PLUS = TINY_PLUS,           /* + */
+    MINUS = TINY_MINUS,         /* - */
+    TIMES = TINY_TIMES,         /* * */
+    OVER = TINY_OVER,           /* / */
+    LPAREN = TINY_LPAREN,       /* ( */
+    RPAREN = TINY_RPAREN,       /* ) */
+    SEMI = TINY_SEMI,           /* ; */
+    MT = TINY_MT,               /* > */
+    LE = TINY_LE,               /* <= */
+    ME = TINY_ME,               /* >= */
+    COMMA = TINY_COMMA,         /* , */
+    QUOTATION = TINY_QUOTATION, /* ' */
+    PERCENT = TINY_PERCENT      /* % */
 } TokenType;
 
 /* extern 在一个文件中引用另一个文件中定义的变量或者函数 */
-/* 一下4个变量都在mian.c定义 */
-extern FILE *source;  /* source code text file */
+/* the variables below belong to the command-line
+ * driver and are defined in main.c; the library
+ * never reads them
+ * 以下变量属于命令行驱动程序，在main.c中定义，库从不读取它们
+ */
 extern FILE *listing; /* listing output text file */
 extern FILE *code; /* code text file for TM simulator */
 
-extern int lineno;      /* source line number for listing */
-extern int CommentLine; /*指示comment的行数*/
-extern int StringLine;  /*指示string的函数*/
-
 /**************************************************/
 /***********   Syntax tree for parsing ************/
 /***********          语法树解析        ************/
 /**************************************************/
 
+/* the kinds and types below mirror those of the
+ * public interface
+ * 以下种类与类型与公共接口中的一一对应
+ */
 typedef enum
 {
-    StmtK,
-    ExpK
+    StmtK = TINY_STMTK,
+    ExpK = TINY_EXPK
 } NodeKind;
 typedef enum
 {
-    IfK,
-    RepeatK,
-    AssignK,
-    ReadK,
-    WriteK
+    IfK = TINY_IFK,
+    RepeatK = TINY_REPEATK,
+    AssignK = TINY_ASSIGNK,
+    ReadK = TINY_READK,
+    WriteK = TINY_WRITEK
 } StmtKind;
 typedef enum
 {
-    OpK,
-    ConstK,
-    IdK
+    OpK = TINY_OPK,
+    ConstK = TINY_CONSTK,
+    IdK = TINY_IDK,
+    StrK = TINY_STRK  /* string literal, attr.val is its pool index */
 } ExpKind;
 
 /* ExpType is used for type checking */
 /* ExpType用于类型检查 */
 typedef enum
 {
-    Void,
-    Integer,
-    Boolean
+    Void = TINY_VOID,
+    Integer = TINY_INTEGER,
+    Boolean = TINY_BOOLEAN
 } ExpType;
 
-#define MAXCHILDREN 3
+#define MAXCHILDREN TINY_MAXCHILDREN
+
+/* NAMEINLINE = the longest name kept inside a node */
+/* NAMEINLINE =保存在节点内部的最长名字 */
+#define NAMEINLINE 15
+
+/* Name holds an identifier: one of up to NAMEINLINE
+ * characters is kept inline, NUL padded, with tag 0;
+ * a longer one is kept in a heap buffer, with tag
+ * NAMEEXTERNAL; use the name functions in util.h
+ * Name保存标识符：不超过NAMEINLINE个字符的名字以NUL填充保存在内部，tag为0；
+ * 更长的名字保存在堆缓冲区中，tag为NAMEEXTERNAL；应使用util.h中的名字函数
+ */
+#define NAMEEXTERNAL 0xFF
+
+typedef union
+{
+    char inl[NAMEINLINE + 1];
+    struct
+    {
+        char *text;
+        uint32_t len;
+        unsigned char pad[NAMEINLINE - sizeof(char *) - sizeof(uint32_t)];
+        unsigned char tag; /* same byte as inl[NAMEINLINE] */
+    } ext;
+} Name;
+
+/* nameText and nameEqual read ext.tag to tell the two
+ * forms apart, so it must overlay the last byte of inl
+ * nameText和nameEqual通过ext.tag区分两种形式，因此它必须与inl的最后一个字节重合
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+_Static_assert(offsetof(Name, ext.tag) == NAMEINLINE, "Name ext.tag must overlay inl[NAMEINLINE]");
+_Static_assert(sizeof(Name) == NAMEINLINE + 1, "Name must be NAMEINLINE + 1 bytes");
+#else
+typedef char NameTagCheck[offsetof(Name, ext.tag) == NAMEINLINE ? 1 : -1];
+typedef char NameSizeCheck[sizeof(Name) == NAMEINLINE + 1 ? 1 : -1];
+#endif
 
 typedef struct treeNode
 {
     struct treeNode *child[MAXCHILDREN];
     struct treeNode *sibling; /* 兄弟 */
+    union
+    {
+        TokenType op;
+        int val;
+        Name name;
+    } attr;
     int lineno;
     NodeKind nodekind;
     union
@@ -118,12 +177,6 @@ typedef struct treeNode
         StmtKind stmt;
         ExpKind exp;
     } kind;
-    union
-    {
-        TokenType op;
-        int val;
-        char *name;
-    } attr;
     ExpType type; /* for type checking of exps */
 } TreeNode;
 
@@ -168,11 +221,4 @@ extern bool TraceCode;
 /* Error = TRUE prevents further passes if an error occurs */
 extern bool Error;
 
-/*true指示string和comment闭合*/
-extern bool StringOver;
-extern bool CommentOver;
-/*True指示string跨行*/
-extern bool StringStraddle;
-/*true指示id，num和keyword之间有空白符*/
-extern bool separate;
 #endif
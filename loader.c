@@ -0,0 +1,675 @@
+/****************************************************/
+/* File: loader.c                                   */
+/* Batched source loading implementation            */
+/* 批量源文件读取的实现                             */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "loader.h"
+
+/* state of one file */
+/* 一个文件的状态 */
+typedef enum {
+    PENDING,
+    LOADED,
+    FAILED,
+    TOOLARGE  /* over the budget, not read */
+} SlotState;
+
+typedef struct {
+    SlotState state;
+    char *buf;       /* text of the file */
+    size_t len;      /* length of the text */
+    size_t reserved; /* bytes counted against the budget */
+    bool released;   /* released by the compiler */
+} Slot;
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef TINY_IO_URING
+typedef struct Ring Ring;
+typedef struct RingFile RingFile;
+#endif
+
+struct Loader {
+    char **paths;
+    int count;
+    int depth;
+    size_t budget;
+    Slot *slots;
+    int nextClaim;   /* next file a thread may start on */
+    int nextAdmit;   /* next file allowed to reserve budget */
+    int released;    /* files before this one are all released */
+    size_t inflight; /* bytes reserved and not released */
+    bool stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int nthreads;
+    pthread_t *threads;
+#ifdef TINY_IO_URING
+    Ring *ring;      /* queue of opens and reads, or NULL for the pool */
+    RingFile *files; /* progress of each file through the ring */
+#endif
+};
+
+/* readFile reads the text of fd, size bytes with pread
+   for a regular file, until end of file otherwise */
+/* readFile读取fd的文本：普通文件用pread读取size个字节，否则读到文件末尾 */
+static bool readFile(int fd, size_t size, char **text, size_t *len) {
+    size_t cap = size > 0 ? size : 65536;
+    size_t n = 0;
+    char *buf = (char *) malloc(cap);
+    if (buf == NULL)
+        return false;
+    countAlloc(ALLOC_SOURCE, cap);
+    for (;;) {
+        ssize_t r;
+        if (n == cap) {
+            char *t;
+            if (size > 0)
+                break;
+            t = (char *) realloc(buf, cap *= 2);
+            if (t == NULL) {
+                free(buf);
+                return false;
+            }
+            countAlloc(ALLOC_SOURCE, cap);
+            buf = t;
+        }
+        r = size > 0 ? pread(fd, buf + n, cap - n, (off_t) n) : read(fd, buf + n, cap - n);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            free(buf);
+            return false;
+        }
+        if (r == 0)
+            break;
+        n += (size_t) r;
+    }
+    *text = buf;
+    *len = n;
+    return true;
+}
+
+/* loadLoop claims files in order and reads them; files
+   reserve budget in order too, so the oldest file the
+   compiler waits for can always be admitted */
+/* loadLoop按顺序领取并读取文件；文件也按顺序预留额度，
+   因此编译器等待的最早文件总能被接纳 */
+static void *loadLoop(void *arg) {
+    Loader *ld = (Loader *) arg;
+    pthread_mutex_lock(&ld->lock);
+    for (;;) {
+        struct stat sb;
+        char *buf = NULL;
+        size_t len = 0;
+        size_t size;
+        size_t large = 0; /* size of a file over the budget */
+        bool ok;
+        int fd;
+        int i;
+        while (!ld->stop && ld->nextClaim < ld->count && ld->nextClaim >= ld->released + ld->depth)
+            pthread_cond_wait(&ld->cond, &ld->lock);
+        if (ld->stop || ld->nextClaim >= ld->count)
+            break;
+        i = ld->nextClaim++;
+        pthread_mutex_unlock(&ld->lock);
+
+        fd = open(ld->paths[i], O_RDONLY);
+        size = fd >= 0 && fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) ? (size_t) sb.st_size : 0;
+        /* 超过额度的文件不读入，也不占用额度 */
+        if (size > ld->budget) {
+            close(fd);
+            fd = -1;
+            large = size;
+            size = 0;
+        }
+
+        pthread_mutex_lock(&ld->lock);
+        while (!ld->stop && (ld->nextAdmit != i || (ld->inflight > 0 && ld->inflight + size > ld->budget)))
+            pthread_cond_wait(&ld->cond, &ld->lock);
+        if (ld->stop) {
+            if (fd >= 0)
+                close(fd);
+            break;
+        }
+        ld->nextAdmit++;
+        ld->inflight += size;
+        ld->slots[i].reserved = size;
+        pthread_cond_broadcast(&ld->cond);
+        pthread_mutex_unlock(&ld->lock);
+
+        ok = fd >= 0 && readFile(fd, size, &buf, &len);
+        if (fd >= 0)
+            close(fd);
+
+        pthread_mutex_lock(&ld->lock);
+        /* 大小未知的文件读完后再计入 */
+        if (size == 0 && ok) {
+            ld->inflight += len;
+            ld->slots[i].reserved = len;
+        }
+        ld->slots[i].buf = buf;
+        ld->slots[i].len = ok ? len : large;
+        ld->slots[i].state = ok ? LOADED : large > 0 ? TOOLARGE : FAILED;
+        pthread_cond_broadcast(&ld->cond);
+    }
+    pthread_mutex_unlock(&ld->lock);
+    return NULL;
+}
+
+#ifdef TINY_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/* MAXREAD bounds the bytes asked of one read, whose
+   length is 32 bits in a submission */
+/* MAXREAD =一次读取请求的字节数上限，提交项中的长度只有32位 */
+#define MAXREAD ((size_t) 1 << 30)
+
+/* an io_uring set up with the raw system calls: the
+   submission and completion rings are shared with the
+   kernel, which owns the submission head and the
+   completion tail */
+/* 用原始系统调用建立的io_uring：提交环和完成环与内核共享，
+   提交环的头和完成环的尾归内核所有 */
+struct Ring {
+    int fd;
+    unsigned entries;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned sqMask;
+    unsigned *sqArray;
+    struct io_uring_sqe *sqes;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+    void *sqMap;       /* submission ring, and the completion ring if cqMap is NULL */
+    size_t sqMapLen;
+    void *cqMap;
+    size_t cqMapLen;
+    size_t sqesLen;
+    unsigned queued;   /* entries not yet submitted */
+    unsigned pending;  /* entries submitted and not completed */
+};
+
+/* where a file is on its way through the ring; each
+   file has at most one request in flight */
+/* 文件在环中所处的步骤；每个文件至多有一个请求在途 */
+typedef enum {
+    RING_IDLE,
+    RING_OPENING,
+    RING_OPENED,   /* open, waiting for budget */
+    RING_READING,
+    RING_SKIPPED,  /* failed or over the budget, no budget needed */
+    RING_DONE
+} RingStep;
+
+struct RingFile {
+    RingStep step;
+    int fd;
+    size_t size;   /* size of a regular file, 0 otherwise */
+    size_t large;  /* size of a file over the budget */
+    char *buf;
+    size_t n;      /* bytes read so far */
+};
+
+/* ringClose unmaps and closes ring */
+/* ringClose解除ring的映射并关闭它 */
+static void ringClose(Ring *ring) {
+    if (ring->sqes != MAP_FAILED)
+        munmap(ring->sqes, ring->sqesLen);
+    if (ring->cqMap != NULL && ring->cqMap != MAP_FAILED)
+        munmap(ring->cqMap, ring->cqMapLen);
+    if (ring->sqMap != MAP_FAILED)
+        munmap(ring->sqMap, ring->sqMapLen);
+    close(ring->fd);
+    free(ring);
+}
+
+/* ringOpen sets up a ring of at least entries entries,
+   or returns NULL when the kernel has no io_uring or
+   does not allow it */
+/* ringOpen建立至少有entries项的环；内核没有或不允许io_uring时返回NULL */
+static Ring *ringOpen(unsigned entries) {
+    struct io_uring_params p;
+    Ring *ring = (Ring *) calloc(1, sizeof(Ring));
+    char *sq;
+    char *cq;
+    if (ring == NULL)
+        return NULL;
+    memset(&p, 0, sizeof(p));
+    ring->fd = (int) syscall(__NR_io_uring_setup, entries, &p);
+    if (ring->fd < 0) {
+        free(ring);
+        return NULL;
+    }
+    ring->entries = p.sq_entries;
+    ring->sqMapLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cqMapLen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesLen = p.sq_entries * sizeof(struct io_uring_sqe);
+    /* 新内核的两个环可以一次映射 */
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cqMapLen > ring->sqMapLen)
+            ring->sqMapLen = ring->cqMapLen;
+        ring->cqMapLen = 0;
+    }
+    ring->sqMap = mmap(NULL, ring->sqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring->fd, IORING_OFF_SQ_RING);
+    ring->cqMap = ring->cqMapLen == 0 ? NULL
+                  : mmap(NULL, ring->cqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes = (struct io_uring_sqe *) mmap(NULL, ring->sqesLen, PROT_READ | PROT_WRITE,
+                                              MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqMap == MAP_FAILED || ring->cqMap == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        ringClose(ring);
+        return NULL;
+    }
+    sq = (char *) ring->sqMap;
+    cq = ring->cqMap != NULL ? (char *) ring->cqMap : sq;
+    ring->sqHead = (unsigned *) (sq + p.sq_off.head);
+    ring->sqTail = (unsigned *) (sq + p.sq_off.tail);
+    ring->sqMask = *(unsigned *) (sq + p.sq_off.ring_mask);
+    ring->sqArray = (unsigned *) (sq + p.sq_off.array);
+    ring->cqHead = (unsigned *) (cq + p.cq_off.head);
+    ring->cqTail = (unsigned *) (cq + p.cq_off.tail);
+    ring->cqMask = *(unsigned *) (cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+    return ring;
+}
+
+/* ringPush queues a request for file i, and returns
+   false if the submission ring is full */
+/* ringPush为第i个文件排入一个请求，提交环已满时返回false */
+static bool ringPush(Ring *ring, int op, int fd, const void *addr, size_t len, size_t off, int i) {
+    unsigned tail = *ring->sqTail;
+    unsigned slot;
+    struct io_uring_sqe *sqe;
+    if (tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) >= ring->entries)
+        return false;
+    slot = tail & ring->sqMask;
+    sqe = &ring->sqes[slot];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (uint8_t) op;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) addr;
+    sqe->len = (uint32_t) len;
+    sqe->off = (uint64_t) off;
+    sqe->user_data = (uint64_t) i;
+    ring->sqArray[slot] = slot;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ring->queued++;
+    return true;
+}
+
+/* ringEnter submits the queued requests and waits for
+   at least one completion; it returns false if the
+   ring can no longer be used */
+/* ringEnter提交排队的请求并等待至少一个完成；环无法再使用时返回false */
+static bool ringEnter(Ring *ring) {
+    long r = syscall(__NR_io_uring_enter, ring->fd, ring->queued, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (r >= 0) {
+        ring->queued -= (unsigned) r;
+        ring->pending += (unsigned) r;
+        return true;
+    }
+    /* 被信号打断或暂时没有资源时，回到循环中收取已完成的请求后重试 */
+    return errno == EINTR || errno == EAGAIN || errno == EBUSY;
+}
+
+/* ringReap takes the next completion into cqe, and
+   returns false if there is none */
+/* ringReap将下一个完成项取到cqe中，没有时返回false */
+static bool ringReap(Ring *ring, struct io_uring_cqe *cqe) {
+    unsigned head = *ring->cqHead;
+    if (head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE))
+        return false;
+    *cqe = ring->cqes[head & ring->cqMask];
+    __atomic_store_n(ring->cqHead, head + 1, __ATOMIC_RELEASE);
+    ring->pending--;
+    return true;
+}
+
+/* ringPublish hands file i to loaderWait, loaded if ok */
+/* ringPublish将第i个文件交给loaderWait，ok时为已读入 */
+static void ringPublish(Loader *ld, int i, bool ok) {
+    RingFile *f = &ld->files[i];
+    if (f->fd >= 0)
+        close(f->fd);
+    f->fd = -1;
+    if (!ok) {
+        free(f->buf);
+        f->buf = NULL;
+    }
+    ld->slots[i].buf = f->buf;
+    ld->slots[i].len = ok ? f->n : f->large;
+    ld->slots[i].state = ok ? LOADED : f->large > 0 ? TOOLARGE : FAILED;
+    f->buf = NULL;
+    pthread_cond_broadcast(&ld->cond);
+}
+
+/* ringOpened sizes file i once its open completed with
+   res; the open is redone here if the kernel has no
+   openat request */
+/* ringOpened在第i个文件以结果res打开后确定其大小；内核没有openat请求时在此重新打开 */
+static void ringOpened(Loader *ld, int i, int res) {
+    RingFile *f = &ld->files[i];
+    struct stat sb;
+    f->fd = res == -EINVAL || res == -EOPNOTSUPP ? open(ld->paths[i], O_RDONLY) : res;
+    f->size = f->fd >= 0 && fstat(f->fd, &sb) == 0 && S_ISREG(sb.st_mode) ? (size_t) sb.st_size : 0;
+    /* 超过额度的文件不读入，也不占用额度 */
+    if (f->size > ld->budget) {
+        f->large = f->size;
+        f->size = 0;
+        close(f->fd);
+        f->fd = -1;
+    }
+    if (f->fd < 0 || ld->stop) {
+        ringPublish(ld, i, false);
+        f->step = RING_SKIPPED;
+    } else
+        f->step = RING_OPENED;
+}
+
+/* ringRead handles the completion res of a read of
+   file i, asking for the rest after a short read; a
+   read the kernel does not support is redone with
+   pread */
+/* ringRead处理第i个文件一次读取的结果res，读得不足时请求其余部分；
+   内核不支持的读取改用pread完成 */
+static void ringRead(Loader *ld, int i, int res) {
+    RingFile *f = &ld->files[i];
+    size_t rest;
+    if ((res == -EINVAL || res == -EOPNOTSUPP) && f->n == 0) {
+        free(f->buf);
+        f->buf = NULL;
+        ringPublish(ld, i, readFile(f->fd, f->size, &f->buf, &f->n));
+        f->step = RING_DONE;
+        return;
+    }
+    if (res == -EINTR || res == -EAGAIN)
+        res = 0;
+    else if (res < 0 || ld->stop) {
+        ringPublish(ld, i, false);
+        f->step = RING_DONE;
+        return;
+    } else if (res == 0) {
+        /* 文件在打开后被截短 */
+        ringPublish(ld, i, true);
+        f->step = RING_DONE;
+        return;
+    }
+    f->n += (size_t) res;
+    rest = f->size - f->n;
+    if (rest == 0)
+        ringPublish(ld, i, true);
+    else if (!ringPush(ld->ring, IORING_OP_READ, f->fd, f->buf + f->n, rest < MAXREAD ? rest : MAXREAD, f->n, i))
+        ringPublish(ld, i, false);
+    else
+        return;
+    f->step = RING_DONE;
+}
+
+/* ringAdmit reserves budget for file i and starts its
+   read; files of unknown size are read here to the
+   end, as with the pool */
+/* ringAdmit为第i个文件预留额度并开始读取；大小未知的文件与线程池一样在此读到末尾 */
+static void ringAdmit(Loader *ld, int i) {
+    RingFile *f = &ld->files[i];
+    ld->inflight += f->size;
+    ld->slots[i].reserved = f->size;
+    if (f->size == 0) {
+        int fd = f->fd;
+        char *buf = NULL;
+        size_t len = 0;
+        bool ok;
+        f->fd = -1;
+        f->step = RING_DONE;
+        pthread_mutex_unlock(&ld->lock);
+        ok = readFile(fd, 0, &buf, &len);
+        close(fd);
+        pthread_mutex_lock(&ld->lock);
+        if (ok) {
+            ld->inflight += len;
+            ld->slots[i].reserved = len;
+        }
+        f->buf = buf;
+        f->n = len;
+        ringPublish(ld, i, ok);
+        return;
+    }
+    f->buf = (char *) malloc(f->size);
+    if (f->buf != NULL)
+        countAlloc(ALLOC_SOURCE, f->size);
+    if (f->buf == NULL
+        || !ringPush(ld->ring, IORING_OP_READ, f->fd, f->buf, f->size < MAXREAD ? f->size : MAXREAD, 0, i)) {
+        ringPublish(ld, i, false);
+        f->step = RING_DONE;
+    } else
+        f->step = RING_READING;
+}
+
+/* ringLoop reads the files on one thread through the
+   ring: the opens and reads of up to depth files are
+   in flight at once, and budget is reserved in file
+   order as loadLoop does */
+/* ringLoop在一个线程上通过环读取文件：至多depth个文件的打开和读取同时在途，
+   额度与loadLoop一样按文件顺序预留 */
+static void *ringLoop(void *arg) {
+    Loader *ld = (Loader *) arg;
+    Ring *ring = ld->ring;
+    struct io_uring_cqe cqe;
+    int i;
+    pthread_mutex_lock(&ld->lock);
+    for (;;) {
+        /* 领取文件并排入打开请求 */
+        while (!ld->stop && ld->nextClaim < ld->count && ld->nextClaim < ld->released + ld->depth
+               && ringPush(ring, IORING_OP_OPENAT, AT_FDCWD, ld->paths[ld->nextClaim], 0, 0, ld->nextClaim)) {
+            ld->files[ld->nextClaim].fd = -1;
+            ld->files[ld->nextClaim++].step = RING_OPENING;
+        }
+        /* 按顺序接纳已打开的文件 */
+        while (!ld->stop && ld->nextAdmit < ld->nextClaim) {
+            RingFile *f = &ld->files[ld->nextAdmit];
+            if (f->step == RING_SKIPPED)
+                ld->nextAdmit++;
+            else if (f->step == RING_OPENED && (ld->inflight == 0 || ld->inflight + f->size <= ld->budget))
+                ringAdmit(ld, ld->nextAdmit++);
+            else
+                break;
+        }
+        if (ring->queued + ring->pending == 0) {
+            if (ld->stop || ld->nextAdmit >= ld->count)
+                break;
+            pthread_cond_wait(&ld->cond, &ld->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&ld->lock);
+        if (!ringEnter(ring)) {
+            /* 环不可用：尚未读完的文件都作为读取失败，仍在途的缓冲区不释放 */
+            pthread_mutex_lock(&ld->lock);
+            for (i = 0; i < ld->count; i++)
+                if (ld->slots[i].state == PENDING) {
+                    if (ld->files[i].step == RING_READING)
+                        ld->files[i].buf = NULL;
+                    ringPublish(ld, i, false);
+                }
+            ld->nextClaim = ld->nextAdmit = ld->count;
+            break;
+        }
+        pthread_mutex_lock(&ld->lock);
+        while (ringReap(ring, &cqe)) {
+            i = (int) cqe.user_data;
+            if (ld->files[i].step == RING_OPENING)
+                ringOpened(ld, i, cqe.res);
+            else
+                ringRead(ld, i, cqe.res);
+        }
+    }
+    /* 停止时关闭已打开但未接纳的文件 */
+    for (i = 0; i < ld->count; i++)
+        if (ld->files[i].fd >= 0) {
+            close(ld->files[i].fd);
+            ld->files[i].fd = -1;
+        }
+    pthread_mutex_unlock(&ld->lock);
+    return NULL;
+}
+
+#endif
+
+Loader *loaderStart(char **paths, int count, int depth, size_t budget) {
+    Loader *ld = (Loader *) calloc(1, sizeof(Loader));
+    int i;
+    if (ld == NULL)
+        return NULL;
+    if (depth < 1)
+        depth = 1;
+    ld->paths = paths;
+    ld->count = count;
+    ld->depth = depth;
+    ld->budget = budget;
+    ld->slots = (Slot *) calloc((size_t) count, sizeof(Slot));
+    ld->threads = (pthread_t *) calloc((size_t) depth, sizeof(pthread_t));
+    if (ld->slots == NULL || ld->threads == NULL) {
+        free(ld->slots);
+        free(ld->threads);
+        free(ld);
+        return NULL;
+    }
+    pthread_mutex_init(&ld->lock, NULL);
+    pthread_cond_init(&ld->cond, NULL);
+#ifdef TINY_IO_URING
+    /* 有io_uring时一个线程排入全部请求，否则退回到pread线程池 */
+    if (getenv(URING_ENV) == NULL || strcmp(getenv(URING_ENV), "0") != 0) {
+        ld->files = (RingFile *) calloc((size_t) count, sizeof(RingFile));
+        ld->ring = ld->files != NULL ? ringOpen((unsigned) depth) : NULL;
+        if (ld->ring != NULL && pthread_create(&ld->threads[0], NULL, ringLoop, ld) == 0)
+            ld->nthreads = 1;
+        else if (ld->ring != NULL) {
+            ringClose(ld->ring);
+            ld->ring = NULL;
+        }
+    }
+#endif
+    for (i = 0; ld->nthreads == 0 && i < depth && i < count; i++) {
+        if (pthread_create(&ld->threads[i], NULL, loadLoop, ld) != 0)
+            break;
+        ld->nthreads++;
+    }
+    if (ld->nthreads == 0) {
+        loaderFinish(ld);
+        return NULL;
+    }
+    return ld;
+}
+
+const char *loaderWait(Loader *loader, int i, size_t *len) {
+    Slot *slot = &loader->slots[i];
+    pthread_mutex_lock(&loader->lock);
+    while (slot->state == PENDING)
+        pthread_cond_wait(&loader->cond, &loader->lock);
+    pthread_mutex_unlock(&loader->lock);
+    *len = slot->len;
+    return slot->state == LOADED ? slot->buf : NULL;
+}
+
+void loaderRelease(Loader *loader, int i) {
+    Slot *slot = &loader->slots[i];
+    pthread_mutex_lock(&loader->lock);
+    free(slot->buf);
+    slot->buf = NULL;
+    loader->inflight -= slot->reserved;
+    slot->released = true;
+    /* 文件可能不按顺序释放，预读窗口从最早未释放的文件算起 */
+    while (loader->released < loader->count && loader->slots[loader->released].released)
+        loader->released++;
+    pthread_cond_broadcast(&loader->cond);
+    pthread_mutex_unlock(&loader->lock);
+}
+
+void loaderFinish(Loader *loader) {
+    int i;
+    pthread_mutex_lock(&loader->lock);
+    loader->stop = true;
+    pthread_cond_broadcast(&loader->cond);
+    pthread_mutex_unlock(&loader->lock);
+    for (i = 0; i < loader->nthreads; i++)
+        pthread_join(loader->threads[i], NULL);
+    for (i = 0; i < loader->count; i++)
+        free(loader->slots[i].buf);
+#ifdef TINY_IO_URING
+    if (loader->ring != NULL)
+        ringClose(loader->ring);
+    free(loader->files);
+#endif
+    pthread_cond_destroy(&loader->cond);
+    pthread_mutex_destroy(&loader->lock);
+    free(loader->threads);
+    free(loader->slots);
+    free(loader);
+}
+
+#else
+
+/* without threads each file is read when it is needed */
+/* 没有线程时在需要时才读取每个文件 */
+struct Loader {
+    char **paths;
+    Slot slot;
+};
+
+Loader *loaderStart(char **paths, int count, int depth, size_t budget) {
+    Loader *ld = (Loader *) calloc(1, sizeof(Loader));
+    if (ld != NULL)
+        ld->paths = paths;
+    return ld;
+}
+
+const char *loaderWait(Loader *loader, int i, size_t *len) {
+    FILE *f = fopen(loader->paths[i], "r");
+    size_t cap = 0;
+    size_t n;
+    loader->slot.buf = NULL;
+    loader->slot.len = 0;
+    *len = 0;
+    if (f == NULL)
+        return NULL;
+    do {
+        if (loader->slot.len == cap) {
+            char *t = (char *) realloc(loader->slot.buf, cap = cap ? 2 * cap : 65536);
+            if (t == NULL)
+                break;
+            countAlloc(ALLOC_SOURCE, cap);
+            loader->slot.buf = t;
+        }
+        n = fread(loader->slot.buf + loader->slot.len, 1, cap - loader->slot.len, f);
+        loader->slot.len += n;
+    } while (n > 0);
+    fclose(f);
+    *len = loader->slot.len;
+    return loader->slot.buf;
+}
+
+void loaderRelease(Loader *loader, int i) {
+    free(loader->slot.buf);
+    loader->slot.buf = NULL;
+}
+
+void loaderFinish(Loader *loader) {
+    free(loader->slot.buf);
+    free(loader);
+}
+
+#endif
@@ -0,0 +1,68 @@
+/****************************************************/
+/* File: loader.h                                   */
+/* Batched source loading for multi-file runs       */
+/* 多文件编译时的批量源文件读取                     */
+/****************************************************/
+
+#ifndef _LOADER_H_
+#define _LOADER_H_
+
+/* DEPTH_ENV optionally sets how many files are read
+ * ahead of the one being compiled
+ * DEPTH_ENV可选地设置在正在编译的文件之前预读多少个文件
+ */
+#define DEPTH_ENV "TINY_QUEUE_DEPTH"
+
+/* BUDGET_ENV optionally bounds the bytes of files read
+ * but not yet compiled
+ * BUDGET_ENV可选地限制已读取但尚未编译的文件字节数
+ */
+#define BUDGET_ENV "TINY_INFLIGHT_BYTES"
+
+/* URING_ENV set to 0 reads with the pread thread pool
+ * even where io_uring is available
+ * URING_ENV设为0时即使有io_uring也使用pread线程池读取
+ */
+#define URING_ENV "TINY_IO_URING"
+
+#define LOADER_DEFAULT_DEPTH 8
+#define LOADER_DEFAULT_BUDGET ((size_t) 256 * 1024 * 1024)
+
+typedef struct Loader Loader;
+
+/* Function loaderStart starts reading the count files
+ * in paths, depth of them at once, keeping at most
+ * budget bytes in flight; the opens and reads are
+ * queued on one io_uring where the kernel allows it,
+ * else done on depth threads with pread; a regular
+ * file larger than budget is left for the caller to
+ * scan in place
+ * 函数loaderStart开始读取paths中的count个文件，同时读取depth个，
+ * 在途字节数不超过budget；内核允许时打开和读取都排入一个io_uring，
+ * 否则在depth个线程上用pread完成；大于budget的普通文件留给调用者就地扫描
+ */
+Loader *loaderStart(char **paths, int count, int depth, size_t budget);
+
+/* Function loaderWait waits until file i is read and
+ * returns its text and length; it returns NULL with
+ * length 0 if the file could not be read, and NULL
+ * with the file size if it is larger than the budget
+ * 函数loaderWait等待第i个文件读完并返回其文本和长度；无法读取时返回NULL且长度为0，
+ * 大于额度时返回NULL且长度为文件大小
+ */
+const char *loaderWait(Loader *loader, int i, size_t *len);
+
+/* Function loaderRelease frees the text of file i and
+ * lets the loader read further ahead; files may be
+ * released in any order
+ * 函数loaderRelease释放第i个文件的文本，使读取器可以继续预读；文件可以按任意顺序释放
+ */
+void loaderRelease(Loader *loader, int i);
+
+/* Function loaderFinish stops the threads and frees
+ * the loader
+ * 函数loaderFinish停止线程并释放读取器
+ */
+void loaderFinish(Loader *loader);
+
+#endif
@@ -0,0 +1,88 @@
+/****************************************************/
+/* File: lookahead.c                                */
+/* Token lookahead buffer for TINY parsers          */
+/* 语法分析器的token预读缓冲区                      */
+/****************************************************/
+
+#include "globals.h"
+
+/* the tokens read ahead are tok[head..head+count),
+   modulo k; once ENDFILE is read it is repeated
+   without scanning again */
+/* 预读的token为tok[head..head+count)（模k）；读到ENDFILE后不再扫描，而是重复它 */
+struct TinyLookahead {
+    TinyScanner *scanner;
+    int k;
+    int head;
+    int count;
+    bool ended;
+    TinyToken tok[];
+};
+
+TinyLookahead *tinyLookaheadOpen(TinyScanner *scanner, int k) {
+    TinyLookahead *la;
+    if (k < 1)
+        k = 1;
+    la = (TinyLookahead *) malloc(sizeof(TinyLookahead) + (size_t) k * sizeof(TinyToken));
+    if (la == NULL)
+        return NULL;
+    la->scanner = scanner;
+    la->k = k;
+    la->head = 0;
+    la->count = 0;
+    la->ended = false;
+    return la;
+}
+
+/* fill reads one more token into the buffer */
+/* fill向缓冲区多读入一个token */
+static void fill(TinyLookahead *la) {
+    TinyToken *t = &la->tok[(la->head + la->count) % la->k];
+    TinyScanner *sc = la->scanner;
+    if (la->ended) {
+        *t = la->tok[(la->head + la->count + la->k - 1) % la->k];
+        la->count++;
+        return;
+    }
+    tinySave(sc, &t->before);
+    t->kind = tinyNextToken(sc);
+    t->line = tinyTokenLine(sc);
+    t->offset = tinyTokenOffset(sc);
+    t->value = tinyTokenValue(sc);
+    t->fvalue = tinyTokenFloat(sc);
+    strcpy(t->text, tinyTokenString(sc));
+    la->ended = t->kind == TINY_ENDFILE;
+    la->count++;
+}
+
+const TinyToken *tinyPeek(TinyLookahead *la, int i) {
+    if (i < 0 || i >= la->k)
+        return NULL;
+    while (la->count <= i)
+        fill(la);
+    return &la->tok[(la->head + i) % la->k];
+}
+
+const TinyToken *tinyAdvance(TinyLookahead *la) {
+    const TinyToken *t = tinyPeek(la, 0);
+    la->head = (la->head + 1) % la->k;
+    la->count--;
+    return t;
+}
+
+void tinyMark(TinyLookahead *la, TinyCheckpoint *checkpoint) {
+    if (la->count > 0)
+        *checkpoint = la->tok[la->head].before;
+    else
+        tinySave(la->scanner, checkpoint);
+}
+
+void tinyReset(TinyLookahead *la, const TinyCheckpoint *checkpoint) {
+    tinyRestore(la->scanner, checkpoint);
+    la->count = 0;
+    la->ended = false;
+}
+
+void tinyLookaheadClose(TinyLookahead *la) {
+    free(la);
+}
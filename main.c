@@ -6,6 +6,16 @@
 /****************************************************/
 
 #include "globals.h"
+#include "util.h"
+#include "server.h"
+#include "cache.h"
+#include "loader.h"
+#include "trace.h"
+#include "report.h"
+#include "watch.h"
+#include "parallel.h"
+
+#include <errno.h>
 
 /* set NO_PARSE to TRUE to get a scanner-only compiler */
 /* 将NO_PARSE设置为TRUE可获得仅扫描程序的编译器 */
@@ -20,15 +30,19 @@
  */
 #define NO_CODE false
 
-#include "util.c"
-#include "scan.c"
+/* TRACE_BUILT is false when the scanner's echo and
+ * trace points were compiled away, which changes the
+ * listing
+ * 扫描器的回显和跟踪点被编译删除时TRACE_BUILT为false，这会改变列表
+ */
+#ifdef TINY_NO_TRACE
+#define TRACE_BUILT false
+#else
+#define TRACE_BUILT true
+#endif
 
 /* allocate global variables */
 /* 分配全局变量 */
-int lineno = 0;
-int CommentLine = 0;
-int StringLine = 0;
-FILE *source;
 FILE *listing;
 FILE *code;
 
@@ -42,36 +56,438 @@ bool TraceCode = false;
 
 bool Error = false;
 
-/*分配和设置string和comment的标志*/
-bool StringOver = true;
-bool CommentOver = true;
-bool StringStraddle = false;
-bool separate = false;
+/* traceFile receives the binary trace events when
+ * TRACE_ENV is set
+ * 设置TRACE_ENV时traceFile接收二进制跟踪事件
+ */
+static FILE *traceFile = NULL;
 
-int main(int argc, char *argv[]) {
-    TreeNode *syntaxTree;
-    char pgm[120]; /* source code file name */
-    /* 参数必须有两个 */
-    if (argc != 2) {
-        fprintf(stderr, "usage: %s <filename>\n", argv[0]);
-        exit(1);
+/* LIMIT_ENV optionally sets how many diagnostics stop
+ * a scan when they are collected
+ * LIMIT_ENV可选地设置收集诊断时多少个诊断后停止扫描
+ */
+#define LIMIT_ENV "TINY_ERROR_LIMIT"
+#define DEFAULT_ERROR_LIMIT 100
+
+/* errors are listed inline, or collected and printed
+ * after the listing as text or JSON
+ * 错误在列表中逐个列出，或收集后在列表之后以文本或JSON输出
+ */
+typedef enum {
+    DIAG_INLINE,
+    DIAG_TEXT,
+    DIAG_JSON
+} DiagMode;
+
+static DiagMode diagMode = DIAG_INLINE;
+static int errorLimit = DEFAULT_ERROR_LIMIT;
+
+/* TRACEDRAIN = tokens scanned between reads of the
+ * scanner's trace events, below the 4096 it keeps
+ * TRACEDRAIN =两次读取扫描器跟踪事件之间扫描的token数，小于其保留的4096个
+ */
+#define TRACEDRAIN 1024
+
+/* WRITECHECK = tokens scanned between checks that the
+ * listing can still be written
+ * WRITECHECK =两次检查列表是否仍可写出之间扫描的token数
+ */
+#define WRITECHECK 1024
+
+/* scanFlags turns the tracing flags above into
+ * scanner flags
+ * scanFlags将上面的跟踪标志转换为扫描器标志
+ */
+static unsigned scanFlags(void) {
+    unsigned diagnostics = diagMode != DIAG_INLINE ? TINY_DIAGNOSTICS : 0;
+    /* 二进制跟踪取代回显和文本跟踪，但仍收集诊断 */
+    if (traceFile != NULL)
+        return TINY_TRACE_BINARY | diagnostics;
+    return (EchoSource ? TINY_ECHO_SOURCE : 0) | (TraceScan ? TINY_TRACE_SCAN : 0) | diagnostics;
+}
+
+size_t readSource(FILE *f, char **buf, size_t *cap) {
+    size_t len = 0;
+    size_t n;
+    do {
+        if (len == *cap) {
+            size_t size = *cap ? 2 * *cap : 65536;
+            char *t = (char *) realloc(*buf, size);
+            if (t == NULL)
+                return (size_t) -1;
+            countAlloc(ALLOC_SOURCE, size);
+            *buf = t;
+            *cap = size;
+        }
+        n = fread(*buf + len, 1, *cap - len, f);
+        len += n;
+    } while (n > 0);
+    return len;
+}
+
+/* traceScan scans to the end, moving the scanner's
+ * trace events to traceFile as it goes
+ * traceScan扫描到结束，同时将扫描器的跟踪事件移到traceFile
+ */
+static void traceScan(TinyScanner *scanner) {
+    TinyTraceEvent events[TRACEDRAIN];
+    TinyTokenType token;
+    int n = 0;
+    do {
+        token = tinyNextToken(scanner);
+        if (++n == TRACEDRAIN || token == TINY_ENDFILE) {
+            fwrite(events, sizeof(TinyTraceEvent), tinyTraceRead(scanner, events, TRACEDRAIN), traceFile);
+            n = 0;
+        }
+    } while (token != TINY_ENDFILE);
+}
+
+/* runPasses runs the passes enabled above over the
+ * tokens of scanner for pgm, writing the collected
+ * diagnostics to out
+ * runPasses对pgm的scanner的token执行上面启用的各个阶段，收集的诊断写入out
+ */
+static void runPasses(TinyScanner *scanner, const char *pgm, FILE *out) {
+    tinySetErrorLimit(scanner, errorLimit);
+    if (traceFile != NULL)
+        traceScan(scanner);
+    else {
+        int n = 0;
+        /* 列表写不出去时（例如服务器的客户端不再读取而发送超时）停止扫描 */
+        while (tinyNextToken(scanner) != TINY_ENDFILE)
+            if (++n == WRITECHECK) {
+                if (ferror(out))
+                    break;
+                n = 0;
+            }
+    }
+    /* NO_PARSE为真，不运行语法分析、语义分析和代码生成 */
+    if (diagMode != DIAG_INLINE)
+        tinyPrintDiagnostics(scanner, pgm, out, diagMode == DIAG_JSON);
+}
+
+/* runText runs the passes over the len bytes of text
+ * read from pgm, writing their output to out
+ * runText对从pgm读入的text中的len个字节执行各个阶段，输出写入out
+ */
+static void runText(const char *pgm, const char *text, size_t len, FILE *out) {
+    ReportClock start = reportStart();
+    TinyScanner *scanner = tinyOpenBuffer(text, len, scanFlags(), out);
+    if (scanner == NULL) {
+        fprintf(out, "Out of memory error\n");
+        return;
+    }
+    runPasses(scanner, pgm, out);
+    tinyClose(scanner);
+    reportEnd(PHASE_SCAN, start);
+}
+
+void compile(const char *pgm, const char *text, size_t len, FILE *out) {
+    fprintf(out, "\nTINY COMPILATION: %s\n\n", pgm);
+    runText(pgm, text, len, out);
+}
+
+/* flushListing writes out the rest of the listing when
+ * timing, as the listing phase
+ * flushListing在计时时写出列表的剩余部分，作为列表输出阶段
+ */
+static void flushListing(void) {
+    ReportClock start;
+    if (reporting()) {
+        start = reportStart();
+        fflush(listing);
+        reportEnd(PHASE_LISTING, start);
     }
-    strcpy(pgm, argv[1]);
-    /* strchr 在pgm中寻找第一个出现.的位置 */
-    if (strchr(pgm, '.') == NULL)
-        strcat(pgm, ".tny");
-    source = fopen(pgm, "r");
-    if (source == NULL) {
+}
+
+/* compileInPlace compiles pgm by scanning the file in
+ * place instead of reading it into memory, for sources
+ * larger than the memory budget; the result cache is
+ * not used for them
+ * compileInPlace就地扫描pgm而不将其读入内存，用于大于内存额度的源程序；
+ * 这些源程序不使用结果缓存
+ */
+static int compileInPlace(const char *pgm) {
+    ReportClock start = reportStart();
+    TinyScanner *scanner = tinyOpenFile(pgm, scanFlags(), listing);
+    if (scanner == NULL) {
+        fflush(listing);
         fprintf(stderr, "File %s not found\n", pgm);
-        exit(1);
+        return 1;
     }
-    /* stdout是一个标准输出流 */
-    listing = stdout; /* send listing to screen */
     fprintf(listing, "\nTINY COMPILATION: %s\n\n", pgm);
+    runPasses(scanner, pgm, listing);
+    tinyClose(scanner);
+    reportEnd(PHASE_SCAN, start);
+    flushListing();
+    return 0;
+}
+
+/* cacheFlags packs the settings that change the
+ * listing into the cache key
+ * cacheFlags将影响列表的设置打包进缓存key
+ */
+static unsigned cacheFlags(void) {
+    return (unsigned) EchoSource | (unsigned) TraceScan << 1 | (unsigned) NO_PARSE << 2
+           | (unsigned) NO_ANALYZE << 3 | (unsigned) NO_CODE << 4 | (unsigned) diagMode << 5
+           | (unsigned) !TRACE_BUILT << 7;
+}
+
+/* cachedCompile is compile with the listing taken
+ * from the result cache in dir when text is unchanged
+ * cachedCompile与compile相同，但源程序未改变时从dir中的缓存取得列表
+ */
+static void cachedCompile(const char *pgm, const char *text, size_t len, const char *dir) {
+    char *limit = getenv(CACHE_SIZE_ENV);
+    /* 诊断以文件名开头且受上限约束，此时列表依赖于pgm和errorLimit */
+    uint64_t key = diagMode != DIAG_INLINE ? cacheKey(text, len, pgm, errorLimit, cacheFlags())
+                                           : cacheKey(text, len, NULL, 0, cacheFlags());
+    FILE *tmp;
+    fprintf(listing, "\nTINY COMPILATION: %s\n\n", pgm);
+    if (cacheLookup(dir, key, listing))
+        return;
+    tmp = cacheBegin(dir);
+    if (tmp == NULL)
+        runText(pgm, text, len, listing);
+    else {
+        runText(pgm, text, len, tmp);
+        cacheCommit(dir, key, tmp, listing, limit ? atol(limit) : CACHE_DEFAULT_SIZE);
+    }
+}
+
+/* compileText compiles the len bytes of text read
+ * from pgm, through the result cache when dir is set
+ * compileText编译从pgm读入的text中的len个字节，设置dir时经过结果缓存
+ */
+static void compileText(const char *pgm, const char *text, size_t len, const char *dir) {
+    if (dir != NULL)
+        cachedCompile(pgm, text, len, dir);
+    else
+        compile(pgm, text, len, listing);
+    flushListing();
+}
 
-    while (getToken() != ENDFILE);
+/* compileFiles compiles the count files in pgms in
+ * order, reading ahead of the one being compiled, and
+ * returns the exit status; files larger than the
+ * memory budget are scanned in place. With threads
+ * not -1 each file is compiled on a scanning thread
+ * as soon as it is read, without the result cache
+ * compileFiles按顺序编译pgms中的count个文件，在编译当前文件时预读后面的文件，
+ * 返回退出状态；大于内存额度的文件就地扫描。threads不为-1时每个文件读入后
+ * 立即在扫描线程上编译，不经过结果缓存
+ */
+static int compileFiles(char **pgms, int count, const char *dir, int threads) {
+    char *depth = getenv(DEPTH_ENV);
+    char *budget = getenv(BUDGET_ENV);
+    size_t limit = budget ? (size_t) strtoull(budget, NULL, 10) : LOADER_DEFAULT_BUDGET;
+    Loader *loader;
+    const char *text;
+    size_t len;
+    int status = 0;
+    int i;
+    ReportClock start = reportStart();
+    /* 单个文件不需要预读线程 */
+    if (count == 1) {
+        FILE *source = fopen(pgms[0], "r");
+        char *buf = NULL;
+        size_t cap = 0;
+        long size;
+        if (source == NULL) {
+            fprintf(stderr, "File %s not found\n", pgms[0]);
+            return 1;
+        }
+        /* 普通文件可以得到大小 */
+        if (fseek(source, 0, SEEK_END) == 0 && (size = ftell(source)) >= 0 && (size_t) size > limit) {
+            fclose(source);
+            return compileInPlace(pgms[0]);
+        }
+        rewind(source);
+        len = readSource(source, &buf, &cap);
+        fclose(source);
+        reportEnd(PHASE_READ, start);
+        if (len == (size_t) -1) {
+            fprintf(stderr, "Out of memory error reading %s\n", pgms[0]);
+            return 1;
+        }
+        compileText(pgms[0], buf, len, dir);
+        free(buf);
+        return 0;
+    }
+    loader = loaderStart(pgms, count, depth ? atoi(depth) : LOADER_DEFAULT_DEPTH, limit);
+    if (loader == NULL) {
+        fprintf(stderr, "Out of memory error\n");
+        return 1;
+    }
+    if (threads >= 0) {
+        status = compileLoaded(loader, pgms, count, scanFlags(), threads);
+        loaderFinish(loader);
+        return status;
+    }
+    for (i = 0; i < count; i++) {
+        /* 读取阶段为等待文件读完的时间 */
+        start = reportStart();
+        text = loaderWait(loader, i, &len);
+        reportEnd(PHASE_READ, start);
+        if (text == NULL && len > 0)
+            status |= compileInPlace(pgms[i]);
+        else if (text == NULL) {
+            fflush(listing);
+            fprintf(stderr, "File %s not found\n", pgms[i]);
+            status = 1;
+        } else
+            compileText(pgms[i], text, len, dir);
+        loaderRelease(loader, i);
+    }
+    loaderFinish(loader);
+    return status;
+}
 
-    fclose(source);
+int main(int argc, char *argv[]) {
+    TreeNode *syntaxTree;
+    char **pgms; /* source code file names */
+    char *server = getenv(SERVER_ENV);
+    char *cacheDir = getenv(CACHE_ENV);
+    char *trace = getenv(TRACE_ENV);
+    int arg = 1; /* first file argument */
+    int count;
+    int first = 0;
+    bool watch = false;
+    int parallel = -1; /* scanning threads, -1 when not parallel */
+    int status = 0;
+    int i;
+    /* stdout是一个标准输出流 */
+    listing = stdout; /* send listing to screen */
+    /* -cache-stats: 打印缓存统计 */
+    if (argc == 2 && !strcmp(argv[1], "-cache-stats")) {
+        if (cacheDir == NULL) {
+            fprintf(stderr, "%s is not set\n", CACHE_ENV);
+            exit(1);
+        }
+        cachePrintStats(cacheDir, stdout);
+        return 0;
+    }
+    /* -server <socket>: 作为常驻编译服务运行 */
+    if (argc == 3 && !strcmp(argv[1], "-server"))
+        return runServer(argv[2]);
+    /* -time-report[=json]: 在标准错误输出上报告各阶段的时间和内存 */
+    /* -diagnostics[=json]: 收集错误并在列表之后统一输出 */
+    /* -watch: 文件保存后增量重新编译 */
+    /* -parallel[=N]: 在N个线程上分块扫描一个文件，或同时编译多个文件 */
+    /* -echo: 列表只回显源程序行和错误，不列出token */
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (!strcmp(argv[arg], "-time-report"))
+            reportEnable(false);
+        else if (!strcmp(argv[arg], "-time-report=json"))
+            reportEnable(true);
+        else if (!strcmp(argv[arg], "-diagnostics"))
+            diagMode = DIAG_TEXT;
+        else if (!strcmp(argv[arg], "-diagnostics=json"))
+            diagMode = DIAG_JSON;
+        else if (!strcmp(argv[arg], "-echo"))
+            TraceScan = false;
+        else if (!strcmp(argv[arg], "-watch"))
+            watch = true;
+        else if (!strcmp(argv[arg], "-parallel"))
+            parallel = 0;
+        else if (!strncmp(argv[arg], "-parallel=", 10) && atoi(argv[arg] + 10) > 0)
+            parallel = atoi(argv[arg] + 10);
+        else
+            break;
+    }
+    if (getenv(LIMIT_ENV) != NULL) {
+        char *end;
+        long limit;
+        errno = 0;
+        limit = strtol(getenv(LIMIT_ENV), &end, 10);
+        if (end == getenv(LIMIT_ENV) || *end != '\0' || errno != 0 || limit < 0 || limit > INT_MAX) {
+            fprintf(stderr, "%s must be a number from 0 (no limit) to %d\n", LIMIT_ENV, INT_MAX);
+            exit(1);
+        }
+        errorLimit = (int) limit;
+    }
+    count = argc - arg;
+    /* 至少要有一个文件 */
+    if (count < 1 || argv[arg][0] == '-') {
+        fprintf(stderr, "usage: %s [-echo] [-time-report[=json]] [-diagnostics[=json]] <filename>...\n", argv[0]);
+        fprintf(stderr, "       %s -watch <filename>...\n", argv[0]);
+        fprintf(stderr, "       %s -parallel[=threads] [-time-report[=json]] <filename>...\n", argv[0]);
+        fprintf(stderr, "       %s -server <socket>\n", argv[0]);
+        fprintf(stderr, "       %s -cache-stats\n", argv[0]);
+        exit(1);
+    }
+    /* 重新编译在新扫描器上恢复检查点，不带有此前收集的诊断；计时和跟踪事件也不按行保存 */
+    if (watch && (reporting() || diagMode != DIAG_INLINE || trace != NULL)) {
+        fprintf(stderr, "-watch cannot be combined with -time-report, -diagnostics or %s\n", TRACE_ENV);
+        exit(1);
+    }
+    /* 各块分别收集诊断和跟踪事件，无法合并为一个源程序的结果 */
+    if (parallel >= 0 && (watch || diagMode != DIAG_INLINE || trace != NULL)) {
+        fprintf(stderr, "-parallel cannot be combined with -watch, -diagnostics or %s\n", TRACE_ENV);
+        exit(1);
+    }
+    /* 跟踪事件在本进程中记录，不经过服务器和缓存 */
+    if (trace != NULL) {
+#ifdef TINY_NO_TRACE
+        fprintf(stderr, "%s is set but tracing was disabled at build time\n", TRACE_ENV);
+        exit(1);
+#else
+        traceFile = fopen(trace, "wb");
+        if (traceFile == NULL) {
+            fprintf(stderr, "Unable to open trace file %s\n", trace);
+            exit(1);
+        }
+        fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_LEN, traceFile);
+        server = NULL;
+        cacheDir = NULL;
+#endif
+    }
+    pgms = (char **) malloc((size_t) count * sizeof(char *));
+    for (i = 0; pgms != NULL && i < count; i++) {
+        pgms[i] = (char *) malloc(strlen(argv[arg + i]) + 5);
+        if (pgms[i] == NULL)
+            break;
+        strcpy(pgms[i], argv[arg + i]);
+        /* strchr 在pgm中寻找第一个出现.的位置 */
+        if (strchr(pgms[i], '.') == NULL)
+            strcat(pgms[i], ".tny");
+    }
+    if (pgms == NULL || i < count) {
+        fprintf(stderr, "Out of memory error\n");
+        exit(1);
+    }
+    if (watch)
+        return runWatch(pgms, count, scanFlags());
+    /* 并行扫描不经过服务器和缓存：单个文件分块扫描，多个文件读入后分给各线程；
+       计时按文件累计各阶段，此时多个文件依次编译 */
+    if (parallel >= 0) {
+        server = NULL;
+        cacheDir = NULL;
+        if (count == 1)
+            status |= compileParallel(pgms[0], scanFlags(), parallel);
+        else
+            status |= compileFiles(pgms, count, NULL, reporting() ? -1 : parallel);
+        first = count;
+    }
+    /* 有可用的服务器时转发请求，否则在本进程编译；计时只针对本进程，服务器总是列出token */
+    if (server != NULL && !reporting() && diagMode == DIAG_INLINE && TraceScan) {
+        int st;
+        while (first < count && (st = runClient(server, pgms[first])) >= 0) {
+            status |= st;
+            first++;
+        }
+    }
+    if (first < count)
+        status |= compileFiles(pgms + first, count - first, cacheDir, -1);
+    for (i = 0; i < count; i++)
+        free(pgms[i]);
+    free(pgms);
+    if (traceFile != NULL)
+        fclose(traceFile);
+    if (reporting()) {
+        fflush(listing);
+        reportPrint(stderr);
+    }
 //    system("pause");
-    return 0;
+    return status;
 }
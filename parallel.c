@@ -0,0 +1,436 @@
+/****************************************************/
+/* File: parallel.c                                 */
+/* Parallel scanning implementation                 */
+/* 并行扫描的实现                                   */
+/****************************************************/
+
+#include "globals.h"
+#include "server.h"
+#include "report.h"
+#include "loader.h"
+#include "parallel.h"
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* MAXTHREADS bounds the number of scanning threads */
+/* MAXTHREADS =扫描线程数的上限 */
+#define MAXTHREADS 256
+
+/* MAXCHUNKS bounds the number of chunks of a source */
+/* MAXCHUNKS =一个源程序的块数上限 */
+#define MAXCHUNKS (1 << 20)
+
+/* the listing of a chunk, kept until it is written */
+/* 一个块的列表，保留到被写出为止 */
+typedef struct {
+    char *out;
+    size_t outLen;
+    bool done;
+    bool failed;    /* out of memory while scanning */
+} Part;
+
+/* a source being scanned; chunks are taken in order,
+   at most depth of them ahead of the one written */
+/* 正在扫描的源程序；块按顺序领取，至多领先正在写出的块depth个 */
+typedef struct {
+    const char *text;
+    TinyChunk *chunks;
+    Part *parts;
+    int count;
+    int depth;
+    unsigned flags;
+    int next;       /* next chunk a thread may take */
+    int written;    /* chunks written to the listing */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} Job;
+
+/* scanLoop finds the contexts of chunks in any order */
+/* scanLoop以任意顺序找出各块的上下文 */
+static void *scanLoop(void *arg) {
+    Job *job = (Job *) arg;
+    for (;;) {
+        int i;
+        pthread_mutex_lock(&job->lock);
+        i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->count)
+            break;
+        tinyChunkScan(job->text, &job->chunks[i]);
+    }
+    return NULL;
+}
+
+/* listLoop scans the tokens of chunks into their
+   listings, taking them in order */
+/* listLoop按顺序领取各块，将其token扫描到各自的列表中 */
+static void *listLoop(void *arg) {
+    Job *job = (Job *) arg;
+    pthread_mutex_lock(&job->lock);
+    for (;;) {
+        Part *part;
+        FILE *mem;
+        int i;
+        while (job->next < job->count && job->next >= job->written + job->depth)
+            pthread_cond_wait(&job->cond, &job->lock);
+        if (job->next >= job->count)
+            break;
+        i = job->next++;
+        part = &job->parts[i];
+        pthread_mutex_unlock(&job->lock);
+
+        mem = open_memstream(&part->out, &part->outLen);
+        if (mem != NULL) {
+            TinyScanner *scanner = tinyOpenChunk(job->text, &job->chunks[i], job->flags, mem);
+            if (scanner != NULL) {
+                while (tinyNextToken(scanner) != TINY_ENDFILE);
+                tinyClose(scanner);
+            } else {
+                fprintf(mem, "Out of memory error\n");
+                part->failed = true;
+            }
+            fclose(mem);
+        }
+
+        pthread_mutex_lock(&job->lock);
+        part->done = true;
+        pthread_cond_broadcast(&job->cond);
+    }
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+/* runThreads runs fn on threads threads and returns
+   how many were started */
+/* runThreads在threads个线程上运行fn，返回启动的线程数 */
+static int runThreads(pthread_t *tids, int threads, void *(*fn)(void *), void *arg) {
+    int n = 0;
+    while (n < threads && pthread_create(&tids[n], NULL, fn, arg) == 0)
+        n++;
+    return n;
+}
+
+/* scanText scans the len bytes of text in count chunks
+   on threads threads, writing the listing in order,
+   and returns false if it ran out of memory */
+/* scanText在threads个线程上分count块扫描text中的len个字节，按顺序写出列表；
+   内存不足时返回false */
+static bool scanText(const char *text, size_t len, unsigned flags, int threads, int count) {
+    pthread_t tids[MAXTHREADS];
+    Job job;
+    bool ok = true;
+    int started;
+    int i;
+    job.text = text;
+    job.count = count;
+    job.depth = 4 * threads;
+    job.flags = flags;
+    job.chunks = (TinyChunk *) malloc((size_t) count * sizeof(TinyChunk));
+    job.parts = (Part *) calloc((size_t) count, sizeof(Part));
+    if (job.chunks == NULL || job.parts == NULL) {
+        free(job.chunks);
+        free(job.parts);
+        return false;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+    tinyChunkSplit(text, len, job.chunks, count);
+
+    /* 先推测每块在三种开始上下文下的结果，再按顺序连接 */
+    if (threads > count)
+        threads = count;
+    job.next = 0;
+    started = runThreads(tids, threads, scanLoop, &job);
+    if (started == 0)
+        scanLoop(&job);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    tinyChunkLink(job.chunks, count);
+
+    job.next = 0;
+    job.written = 0;
+    started = runThreads(tids, threads, listLoop, &job);
+    /* 没有线程时在本线程中扫描全部块 */
+    if (started == 0) {
+        job.depth = count;
+        listLoop(&job);
+    }
+    pthread_mutex_lock(&job.lock);
+    for (i = 0; i < count; i++) {
+        Part *part = &job.parts[i];
+        while (!part->done)
+            pthread_cond_wait(&job.cond, &job.lock);
+        pthread_mutex_unlock(&job.lock);
+        if (part->out != NULL)
+            fwrite(part->out, 1, part->outLen, listing);
+        else
+            fprintf(listing, "Out of memory error\n");
+        if (part->out == NULL || part->failed)
+            ok = false;
+        free(part->out);
+        part->out = NULL;
+        pthread_mutex_lock(&job.lock);
+        job.written = i + 1;
+        pthread_cond_broadcast(&job.cond);
+    }
+    pthread_mutex_unlock(&job.lock);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+    free(job.chunks);
+    free(job.parts);
+    return ok;
+}
+
+int compileParallel(const char *pgm, unsigned flags, int threads) {
+    char *chunkEnv = getenv(CHUNK_ENV);
+    size_t chunk = chunkEnv ? (size_t) strtoull(chunkEnv, NULL, 10) : PARALLEL_DEFAULT_CHUNK;
+    ReportClock start = reportStart();
+    struct stat sb;
+    char *buf = NULL;
+    const char *text = NULL;
+    size_t len = 0;
+    size_t count;
+    bool mapped = false;
+    bool ok;
+    int fd = open(pgm, O_RDONLY);
+    if (fd < 0) {
+        fflush(listing);
+        fprintf(stderr, "File %s not found\n", pgm);
+        return 1;
+    }
+    /* 普通文件直接映射，其他文件读入内存 */
+    if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+        void *map = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            text = (const char *) map;
+            len = (size_t) sb.st_size;
+            mapped = true;
+        }
+    }
+    if (!mapped) {
+        FILE *f = fdopen(fd, "r");
+        size_t cap = 0;
+        len = f != NULL ? readSource(f, &buf, &cap) : (size_t) -1;
+        if (f != NULL)
+            fclose(f);
+        else
+            close(fd);
+        if (len == (size_t) -1) {
+            free(buf);
+            fflush(listing);
+            fprintf(stderr, "Out of memory error reading %s\n", pgm);
+            return 1;
+        }
+        text = buf;
+    } else
+        close(fd);
+    reportEnd(PHASE_READ, start);
+
+    start = reportStart();
+    /* 默认每个CPU一个线程 */
+    if (threads < 1)
+        threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1)
+        threads = 1;
+    if (threads > MAXTHREADS)
+        threads = MAXTHREADS;
+    if (chunk == 0)
+        chunk = PARALLEL_DEFAULT_CHUNK;
+    count = len / chunk + 1;
+    if (count > MAXCHUNKS)
+        count = MAXCHUNKS;
+    fprintf(listing, "\nTINY COMPILATION: %s\n\n", pgm);
+    ok = scanText(text, len, flags, threads, (int) count);
+    reportEnd(PHASE_SCAN, start);
+    if (mapped)
+        munmap((void *) text, len);
+    free(buf);
+    if (!ok) {
+        fflush(listing);
+        fprintf(stderr, "Out of memory error\n");
+        return 1;
+    }
+    return 0;
+}
+
+/* the listing of a whole file, kept until it is written */
+/* 一个完整文件的列表，保留到被写出为止 */
+typedef struct {
+    char *out;
+    size_t outLen;
+    bool loaded;    /* read by the loader and scanned */
+    size_t len;     /* size of a file the loader did not read */
+    bool done;
+} FileOut;
+
+/* files handed from the loader to scanning threads;
+   they are taken in order, at most depth of them ahead
+   of the one written */
+/* 从读取器交给扫描线程的文件；文件按顺序领取，至多领先正在写出的文件depth个 */
+typedef struct {
+    Loader *loader;
+    char **pgms;
+    FileOut *outs;
+    int count;
+    int depth;
+    int next;       /* next file a thread may take */
+    int written;    /* files written to the listing */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} FileJob;
+
+/* fileLoop compiles each file as soon as the loader
+   has read it, into a listing of its own */
+/* fileLoop在读取器读完每个文件后立即编译它，写入各自的列表 */
+static void *fileLoop(void *arg) {
+    FileJob *job = (FileJob *) arg;
+    pthread_mutex_lock(&job->lock);
+    for (;;) {
+        FileOut *o;
+        const char *text;
+        int i;
+        while (job->next < job->count && job->next >= job->written + job->depth)
+            pthread_cond_wait(&job->cond, &job->lock);
+        if (job->next >= job->count)
+            break;
+        i = job->next++;
+        o = &job->outs[i];
+        pthread_mutex_unlock(&job->lock);
+
+        text = loaderWait(job->loader, i, &o->len);
+        /* 未读入的文件留给写出线程按顺序处理 */
+        if (text != NULL) {
+            FILE *mem = open_memstream(&o->out, &o->outLen);
+            if (mem != NULL) {
+                compile(job->pgms[i], text, o->len, mem);
+                fclose(mem);
+            }
+            o->loaded = true;
+            loaderRelease(job->loader, i);
+        }
+
+        pthread_mutex_lock(&job->lock);
+        o->done = true;
+        pthread_cond_broadcast(&job->cond);
+    }
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+int compileLoaded(struct Loader *loader, char **pgms, int count, unsigned flags, int threads) {
+    pthread_t tids[MAXTHREADS];
+    FileJob job;
+    int status = 0;
+    int started;
+    int i;
+    if (threads < 1)
+        threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1)
+        threads = 1;
+    if (threads > MAXTHREADS)
+        threads = MAXTHREADS;
+    job.loader = loader;
+    job.pgms = pgms;
+    job.count = count;
+    job.depth = 4 * threads;
+    job.next = 0;
+    job.written = 0;
+    job.outs = (FileOut *) calloc((size_t) count, sizeof(FileOut));
+    if (job.outs == NULL) {
+        fprintf(stderr, "Out of memory error\n");
+        return 1;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+    started = runThreads(tids, threads < count ? threads : count, fileLoop, &job);
+    /* 没有线程时在本线程中编译全部文件 */
+    if (started == 0) {
+        job.depth = count;
+        fileLoop(&job);
+    }
+    pthread_mutex_lock(&job.lock);
+    for (i = 0; i < count; i++) {
+        FileOut *o = &job.outs[i];
+        while (!o->done)
+            pthread_cond_wait(&job.cond, &job.lock);
+        pthread_mutex_unlock(&job.lock);
+        if (o->loaded && o->out != NULL)
+            fwrite(o->out, 1, o->outLen, listing);
+        else if (o->loaded) {
+            fflush(listing);
+            fprintf(stderr, "Out of memory error\n");
+            status = 1;
+        } else {
+            /* 大于额度的文件在此分块扫描，无法读取的文件在此报告 */
+            if (o->len > 0)
+                status |= compileParallel(pgms[i], flags, threads);
+            else {
+                fflush(listing);
+                fprintf(stderr, "File %s not found\n", pgms[i]);
+                status = 1;
+            }
+            loaderRelease(loader, i);
+        }
+        free(o->out);
+        o->out = NULL;
+        pthread_mutex_lock(&job.lock);
+        job.written = i + 1;
+        pthread_cond_broadcast(&job.cond);
+    }
+    pthread_mutex_unlock(&job.lock);
+    for (i = 0; i < started; i++)
+        pthread_join(tids[i], NULL);
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+    free(job.outs);
+    return status;
+}
+
+#else
+
+/* without threads the source is scanned in one piece */
+/* 没有线程时整个源程序一次扫描 */
+int compileParallel(const char *pgm, unsigned flags, int threads) {
+    TinyScanner *scanner = tinyOpenFile(pgm, flags, listing);
+    if (scanner == NULL) {
+        fflush(listing);
+        fprintf(stderr, "File %s not found\n", pgm);
+        return 1;
+    }
+    fprintf(listing, "\nTINY COMPILATION: %s\n\n", pgm);
+    while (tinyNextToken(scanner) != TINY_ENDFILE);
+    tinyClose(scanner);
+    return 0;
+}
+
+/* without threads the files are compiled in turn */
+/* 没有线程时依次编译各文件 */
+int compileLoaded(struct Loader *loader, char **pgms, int count, unsigned flags, int threads) {
+    int status = 0;
+    int i;
+    for (i = 0; i < count; i++) {
+        size_t len;
+        const char *text = loaderWait(loader, i, &len);
+        if (text != NULL)
+            compile(pgms[i], text, len, listing);
+        else if (len > 0)
+            status |= compileParallel(pgms[i], flags, threads);
+        else {
+            fflush(listing);
+            fprintf(stderr, "File %s not found\n", pgms[i]);
+            status = 1;
+        }
+        loaderRelease(loader, i);
+    }
+    return status;
+}
+
+#endif
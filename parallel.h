@@ -0,0 +1,40 @@
+/****************************************************/
+/* File: parallel.h                                 */
+/* Parallel scanning of one large source            */
+/* 一个大源程序的并行扫描                           */
+/****************************************************/
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+/* CHUNK_ENV optionally sets the bytes of source in
+ * each chunk scanned on its own thread
+ * CHUNK_ENV可选地设置在单独线程上扫描的每个块的源程序字节数
+ */
+#define CHUNK_ENV "TINY_CHUNK_BYTES"
+
+#define PARALLEL_DEFAULT_CHUNK ((size_t) 4 * 1024 * 1024)
+
+/* Function compileParallel compiles pgm with scanner
+ * flags, scanning its chunks on threads threads, or one
+ * per CPU when threads is 0, and writes the same
+ * listing as one scanner would; it returns 1 if pgm
+ * cannot be read
+ * 函数compileParallel用扫描器标志flags编译pgm，在threads个线程（为0时每个CPU一个）上扫描其各块，
+ * 写出与单个扫描器相同的列表；无法读取pgm时返回1
+ */
+int compileParallel(const char *pgm, unsigned flags, int threads);
+
+/* Function compileLoaded compiles the count files in
+ * pgms as loader reads them, each on one of threads
+ * threads (one per CPU when threads is 0), and writes
+ * their listings in order; files over the loader's
+ * budget are scanned in chunks with compileParallel.
+ * It returns 1 if a file cannot be read
+ * 函数compileLoaded在读取器读入pgms中的count个文件后立即编译，每个文件在threads个线程
+ * （为0时每个CPU一个）之一上编译，并按顺序写出列表；超过读取器额度的文件用compileParallel
+ * 分块扫描。有文件无法读取时返回1
+ */
+int compileLoaded(struct Loader *loader, char **pgms, int count, unsigned flags, int threads);
+
+#endif
@@ -0,0 +1,110 @@
+/****************************************************/
+/* File: report.c                                   */
+/* Per-phase time and memory report implementation  */
+/* 各阶段时间和内存报告的实现                       */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "report.h"
+
+#ifndef _WIN32
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+static bool enabled = false;
+static bool asJson = false;
+
+/* time spent in each phase and how often it ran */
+/* 每个阶段花费的时间及运行次数 */
+static struct {
+    double wall;
+    double cpu;
+    unsigned long runs;
+} phaseTime[PHASES];
+
+static const char *phaseName[PHASES] = {"read", "scan", "parse", "analyze", "codegen", "listing"};
+
+static const char *allocName[ALLOC_KINDS] = {"newStmtNode", "newExpNode", "copyString", "scanner", "source"};
+
+void reportEnable(bool json) {
+    enabled = true;
+    asJson = json;
+}
+
+bool reporting(void) {
+    return enabled;
+}
+
+ReportClock reportStart(void) {
+    ReportClock c = {0, 0};
+#ifndef _WIN32
+    struct timespec ts;
+    if (!enabled)
+        return c;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    c.wall = (double) ts.tv_sec + ts.tv_nsec / 1e9;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    c.cpu = (double) ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+    if (enabled)
+        c.wall = c.cpu = (double) clock() / CLOCKS_PER_SEC;
+#endif
+    return c;
+}
+
+void reportEnd(Phase phase, ReportClock start) {
+    ReportClock now;
+    if (!enabled)
+        return;
+    now = reportStart();
+    phaseTime[phase].wall += now.wall - start.wall;
+    phaseTime[phase].cpu += now.cpu - start.cpu;
+    phaseTime[phase].runs++;
+}
+
+/* peakRss returns the peak resident set size in KB,
+   or 0 if it is not known */
+/* peakRss返回以KB计的峰值常驻内存，未知时返回0 */
+static long peakRss(void) {
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        return ru.ru_maxrss;
+#endif
+    return 0;
+}
+
+void reportPrint(FILE *out) {
+    int i;
+    if (asJson) {
+        fprintf(out, "{\"phases\": {");
+        for (i = 0; i < PHASES; i++) {
+            fprintf(out, "%s\"%s\": ", i ? ", " : "", phaseName[i]);
+            if (phaseTime[i].runs == 0)
+                fprintf(out, "null");
+            else
+                fprintf(out, "{\"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"runs\": %lu}",
+                        phaseTime[i].wall * 1e3, phaseTime[i].cpu * 1e3, phaseTime[i].runs);
+        }
+        fprintf(out, "}, \"allocations\": {");
+        for (i = 0; i < ALLOC_KINDS; i++)
+            fprintf(out, "%s\"%s\": {\"count\": %lu, \"bytes\": %lu}", i ? ", " : "", allocName[i],
+                    allocStats[i].count, allocStats[i].bytes);
+        fprintf(out, "}, \"peak_rss_kb\": %ld}\n", peakRss());
+        return;
+    }
+    fprintf(out, "\nTINY TIME REPORT\n\n");
+    fprintf(out, "%-12s %12s %12s\n", "phase", "wall (ms)", "cpu (ms)");
+    for (i = 0; i < PHASES; i++) {
+        if (phaseTime[i].runs == 0)
+            fprintf(out, "%-12s %12s %12s\n", phaseName[i], "not run", "-");
+        else
+            fprintf(out, "%-12s %12.3f %12.3f\n", phaseName[i], phaseTime[i].wall * 1e3, phaseTime[i].cpu * 1e3);
+    }
+    fprintf(out, "\n%-12s %12s %12s\n", "allocations", "count", "bytes");
+    for (i = 0; i < ALLOC_KINDS; i++)
+        fprintf(out, "%-12s %12lu %12lu\n", allocName[i], allocStats[i].count, allocStats[i].bytes);
+    fprintf(out, "\npeak RSS: %ld KB\n", peakRss());
+}
@@ -0,0 +1,58 @@
+/****************************************************/
+/* File: report.h                                   */
+/* Per-phase time and memory report                 */
+/* 各阶段的时间和内存报告                           */
+/****************************************************/
+
+#ifndef _REPORT_H_
+#define _REPORT_H_
+
+/* the phases of a compilation */
+/* 编译的各个阶段 */
+typedef enum {
+    PHASE_READ,
+    PHASE_SCAN,
+    PHASE_PARSE,
+    PHASE_ANALYZE,
+    PHASE_CODE,
+    PHASE_LISTING,
+    PHASES
+} Phase;
+
+/* a reading of the wall and cpu clocks in seconds */
+/* 墙钟和CPU时钟的读数（秒） */
+typedef struct {
+    double wall;
+    double cpu;
+} ReportClock;
+
+/* Procedure reportEnable turns on timing, with the
+ * report printed as JSON when json is true
+ * 过程reportEnable开启计时，json为true时以JSON打印报告
+ */
+void reportEnable(bool json);
+
+/* Function reporting returns whether timing is on */
+/* 函数reporting返回是否开启了计时 */
+bool reporting(void);
+
+/* Function reportStart reads the clocks at the start
+ * of a phase
+ * 函数reportStart在阶段开始时读取时钟
+ */
+ReportClock reportStart(void);
+
+/* Procedure reportEnd adds the time since start to
+ * phase; it does nothing when timing is off
+ * 过程reportEnd将自start以来的时间计入phase，未开启计时时什么也不做
+ */
+void reportEnd(Phase phase, ReportClock start);
+
+/* Procedure reportPrint prints the time of each phase,
+ * the allocations of each site and the peak resident
+ * set size to out
+ * 过程reportPrint将各阶段的时间、各位置的分配和峰值常驻内存打印到out
+ */
+void reportPrint(FILE *out);
+
+#endif
@@ -8,6 +8,30 @@
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
+#include "strpool.h"
+#include "diag.h"
+#include "fnum.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#endif
+
+/* tracing(sc, flag) tests a trace setting of sc;
+   building with TINY_NO_TRACE makes it false, so every
+   trace point compiles away */
+/* tracing(sc, flag)测试sc的跟踪设置；使用TINY_NO_TRACE构建时为false，
+   所有跟踪点都被编译器删除 */
+#ifdef TINY_NO_TRACE
+#define tracing(sc, flag) false
+#else
+#define tracing(sc, flag) ((sc)->flag)
+#endif
 
 /* states in scanner DFA */
 typedef enum {
@@ -15,6 +39,10 @@ typedef enum {
     INASSIGN,  /* 分配 */
     INCOMMENT, /* 注释 */
     INNUM,     /* 数字 */
+    INFRAC,    /* 小数部分 */
+    INEXP,     /* 指数e */
+    INEXPSIGN, /* 指数符号 */
+    INEXPNUM,  /* 指数数字 */
     INSTRING,  /*string*/
     INID,      /*  ID  */
     INME,      /* 大于等于 */
@@ -22,50 +50,243 @@ typedef enum {
     DONE
 } StateType;
 
-/* lexeme of identifier or reserved word */
-/* 标识符或保留字的词素 */
-char tokenString[MAXTOKENLEN + 1];
-
-/* BUFLEN = length of the input buffer for
-   source code lines */
-/* BUFLEN =源代码行的输入缓冲区的长度 */
-#define BUFLEN 256
-
-static char lineBuf[BUFLEN];  /* holds the current line */
-static int linepos = 0;       /* current position in LineBuf */
-static int bufsize = 0;       /* current size of buffer string */
-static bool EOF_flag = false; /* corrects ungetNextChar behavior on EOF 纠正了EOF上的ungetNextChar行为*/
-
-/* getNextChar fetches the next non-blank character
-   from lineBuf, reading in a new line if lineBuf is
-   exhausted */
-/* getNextChar从lineBuf获取下一个非空白字符，如果用完lineBuf则换行 */
-static int getNextChar(void) {
-    if (linepos >= bufsize) {
-        /* 行号 */
-        lineno++;
-        /* fgets会读取到第一个换行符/文件末尾/缓冲区最大长度少一个字符 */
-        if (fgets(lineBuf, BUFLEN - 1, source)) {
-            if (EchoSource)
-                fprintf(listing, "%d: %s", lineno, lineBuf);
-            bufsize = strlen(lineBuf);
-            linepos = 0;
-            return lineBuf[linepos++];
-        } else {
-            EOF_flag = true;
-            lineno--;
+/* character classes of the scanner DFA */
+/* 扫描器DFA的字符类别 */
+#define CC_DIGIT  0x01 /* 0-9 */
+#define CC_ALPHA  0x02 /* a-z A-Z */
+#define CC_SPACE  0x04 /* blank, tab, newline, return */
+#define CC_SINGLE 0x08 /* single-character token 单字符token */
+
+/* charClass gives the class of every byte, and for a
+   single-character token its token type; it replaces
+   the locale-dependent isdigit/isalpha */
+/* charClass给出每个字节的类别，单字符token还给出其token类型；
+   取代与locale相关的isdigit/isalpha */
+#define D {CC_DIGIT, ERROR}
+#define A {CC_ALPHA, ERROR}
+#define S {CC_SPACE, ERROR}
+#define T(tok) {CC_SINGLE, tok}
+
+static const struct {
+    unsigned char cls;
+    unsigned char tok;
+} charClass[256] = {
+        ['0'] = D, ['1'] = D, ['2'] = D, ['3'] = D, ['4'] = D,
+        ['5'] = D, ['6'] = D, ['7'] = D, ['8'] = D, ['9'] = D,
+        ['a'] = A, ['b'] = A, ['c'] = A, ['d'] = A, ['e'] = A, ['f'] = A, ['g'] = A,
+        ['h'] = A, ['i'] = A, ['j'] = A, ['k'] = A, ['l'] = A, ['m'] = A, ['n'] = A,
+        ['o'] = A, ['p'] = A, ['q'] = A, ['r'] = A, ['s'] = A, ['t'] = A, ['u'] = A,
+        ['v'] = A, ['w'] = A, ['x'] = A, ['y'] = A, ['z'] = A,
+        ['A'] = A, ['B'] = A, ['C'] = A, ['D'] = A, ['E'] = A, ['F'] = A, ['G'] = A,
+        ['H'] = A, ['I'] = A, ['J'] = A, ['K'] = A, ['L'] = A, ['M'] = A, ['N'] = A,
+        ['O'] = A, ['P'] = A, ['Q'] = A, ['R'] = A, ['S'] = A, ['T'] = A, ['U'] = A,
+        ['V'] = A, ['W'] = A, ['X'] = A, ['Y'] = A, ['Z'] = A,
+        [' '] = S, ['\t'] = S, ['\n'] = S, ['\r'] = S,
+        ['='] = T(EQ), ['+'] = T(PLUS), ['-'] = T(MINUS), ['*'] = T(TIMES),
+        ['/'] = T(OVER), ['('] = T(LPAREN), [')'] = T(RPAREN), [';'] = T(SEMI),
+        [','] = T(COMMA), ['%'] = T(PERCENT)};
+
+#undef D
+#undef A
+#undef S
+#undef T
+
+/* classOf gives the class of c, which is EOF or a
+   value returned by getNextChar */
+/* classOf给出c的类别，c为EOF或getNextChar的返回值 */
+#define classOf(c) ((c) == EOF ? 0 : charClass[(c)].cls)
+
+#ifndef _WIN32
+
+/* ECHOBATCH = number of echoed lines written by one writev */
+/* ECHOBATCH =一次writev写出的回显行数 */
+#define ECHOBATCH 512
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* a batch of echoed lines: each line is a numbered
+   prefix followed by the source bytes themselves, so
+   the source text is never copied */
+/* 一批回显行：每行由行号前缀和源程序字节本身组成，源程序文本不被复制 */
+struct EchoBatch {
+    int fd;
+    int lines;
+    struct iovec iov[2 * ECHOBATCH];
+    char prefix[ECHOBATCH][16];
+};
+
+/* flushEcho writes the batched lines to the listing */
+/* flushEcho将批量的回显行写入列表 */
+static void flushEcho(TinyScanner *sc) {
+    EchoBatch *b = sc->echo;
+    struct iovec *iov = b->iov;
+    int cnt = 2 * b->lines;
+    if (cnt == 0)
+        return;
+    b->lines = 0;
+    /* 先写出stdio缓冲区中已有的内容 */
+    fflush(sc->listing);
+    while (cnt > 0) {
+        ssize_t n = writev(b->fd, iov, cnt > IOV_MAX ? IOV_MAX : cnt);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        /* 跳过已写出的部分 */
+        while (cnt > 0 && (size_t) n >= iov->iov_len) {
+            n -= (ssize_t) iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            iov->iov_base = (char *) iov->iov_base + n;
+            iov->iov_len -= (size_t) n;
+        }
+    }
+}
+
+/* batchEcho adds a line to the batch */
+/* batchEcho将一行加入批量 */
+static void batchEcho(TinyScanner *sc, const char *line, size_t len) {
+    EchoBatch *b = sc->echo;
+    char *prefix = b->prefix[b->lines];
+    char digits[12];
+    int n = 0;
+    int k = 0;
+    unsigned v = (unsigned) sc->lineno;
+    do
+        digits[n++] = (char) ('0' + v % 10);
+    while ((v /= 10) != 0);
+    while (n > 0)
+        prefix[k++] = digits[--n];
+    prefix[k++] = ':';
+    prefix[k++] = ' ';
+    b->iov[2 * b->lines].iov_base = prefix;
+    b->iov[2 * b->lines].iov_len = (size_t) k;
+    b->iov[2 * b->lines + 1].iov_base = (void *) line;
+    b->iov[2 * b->lines + 1].iov_len = len;
+    if (++b->lines == ECHOBATCH)
+        flushEcho(sc);
+}
+
+#endif
+
+/* TRACERING = number of trace events a scanner keeps,
+   a power of 2 */
+/* TRACERING =扫描器保留的跟踪事件数，为2的幂 */
+#define TRACERING 4096
+
+/* recorded events are ev[tail..head), modulo TRACERING;
+   when the ring is full the oldest event is dropped */
+/* 已记录的事件为ev[tail..head)（模TRACERING）；环满时丢弃最早的事件 */
+struct TraceRing {
+    size_t head;
+    size_t tail;
+    uint64_t epoch; /* clock when the scanner was opened */
+    TinyTraceEvent ev[TRACERING];
+};
+
+/* traceClock reads a monotonic clock in nanoseconds */
+/* traceClock读取以纳秒计的单调时钟 */
+static uint64_t traceClock(void) {
+#ifndef _WIN32
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+/* traceToken records token as a binary trace event */
+/* traceToken将token记录为二进制跟踪事件 */
+static void traceToken(TinyScanner *sc, TokenType token) {
+    TraceRing *r = sc->trace;
+    TinyTraceEvent *e = &r->ev[r->head++ & (TRACERING - 1)];
+    e->time = traceClock() - r->epoch;
+    e->offset = sc->tokenStart;
+    e->length = (uint32_t) (sc->pos - sc->tokenStart);
+    e->line = sc->lineno;
+    e->kind = (uint16_t) token;
+    e->flags = (sc->NumOverflow ? TINY_TRACE_OVERFLOW : 0) | (sc->StringStraddle ? TINY_TRACE_STRADDLE : 0);
+    if (token == ENDFILE)
+        e->flags |= (!sc->StringOver ? TINY_TRACE_OPEN_STRING : 0) | (!sc->CommentOver ? TINY_TRACE_OPEN_COMMENT : 0);
+    if (r->head - r->tail > TRACERING)
+        r->tail = r->head - TRACERING;
+}
+
+/* echoLine echoes a source line to the listing */
+/* echoLine将一行源程序回显到列表 */
+static void echoLine(TinyScanner *sc, const char *line, size_t len) {
+#ifndef _WIN32
+    if (sc->echo != NULL) {
+        batchEcho(sc, line, len);
+        return;
+    }
+#endif
+    fprintf(sc->listing, "%d: %.*s", sc->lineno, (int) len, line);
+}
+
+#ifndef _WIN32
+
+/* DROPWINDOW = bytes of a mapped source scanned
+   between drops of the pages already scanned */
+/* DROPWINDOW =两次丢弃已扫描页之间扫描的映射源程序字节数 */
+#define DROPWINDOW (16 * 1024 * 1024)
+
+/* dropBehind gives back the pages of a mapped source
+   before the current token, so that scanning a file
+   larger than memory keeps a bounded resident set; the
+   pages are read again from the file if needed */
+/* dropBehind归还映射源程序中当前token之前的页，使扫描比内存还大的文件时
+   常驻内存有界；需要时这些页会从文件中重新读入 */
+static void dropBehind(TinyScanner *sc) {
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t end = sc->tokenStart & ~(page - 1);
+    /* 批量回显中的行仍指向映射 */
+    if (sc->echo != NULL)
+        flushEcho(sc);
+    if (end > sc->dropped)
+        madvise((char *) sc->buf + sc->dropped, end - sc->dropped, MADV_DONTNEED);
+    sc->dropped = end;
+}
+
+#endif
+
+/* getNextChar fetches the next character of the
+   source, echoing each line to the listing when it
+   is entered */
+/* getNextChar获取源程序的下一个字符，进入新行时将该行回显到列表 */
+static int getNextChar(TinyScanner *sc) {
+    if (sc->pos >= sc->lineEnd) {
+        const char *nl;
+        if (sc->pos >= sc->len) {
+            sc->EOF_flag = true;
             return EOF;
         }
-    } else
-        return lineBuf[linepos++];
+        /* 行号 */
+        sc->lineno++;
+#ifndef _WIN32
+        if (sc->mapped && sc->pos - sc->dropped >= DROPWINDOW)
+            dropBehind(sc);
+#endif
+        nl = memchr(sc->buf + sc->pos, '\n', sc->len - sc->pos);
+        sc->lineEnd = nl != NULL ? (size_t) (nl - sc->buf) + 1 : sc->len;
+        if (tracing(sc, EchoSource))
+            echoLine(sc, sc->buf + sc->pos, sc->lineEnd - sc->pos);
+    }
+    return (unsigned char) sc->buf[sc->pos++];
 }
 
 /* ungetNextChar backtracks one character
-   in lineBuf */
-/* ungetNextChar在lineBuf中回溯一个字符 */
-static void ungetNextChar(void) {
-    if (!EOF_flag)
-        linepos--;
+   in the source */
+/* ungetNextChar在源程序中回溯一个字符 */
+static void ungetNextChar(TinyScanner *sc) {
+    if (!sc->EOF_flag)
+        sc->pos--;
 }
 
 /* lookup table of reserved words */
@@ -108,6 +329,145 @@ static TokenType reservedLookup(char *s) {
     return ID;
 }
 
+/* parseEightDigits converts 8 ASCII digits to their value
+   at once (SWAR): adjacent digits are combined into 2-digit,
+   then 4-digit, then 8-digit groups by three multiplies */
+/* parseEightDigits用SWAR一次转换8个数字字符：
+   三次乘法依次合并为2位、4位、8位数 */
+static uint32_t parseEightDigits(const char *s) {
+    uint64_t val;
+    memcpy(&val, s, sizeof(val));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    val = __builtin_bswap64(val);
+#endif
+    val = ((val & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    val = ((val & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    return (uint32_t) (((val & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32);
+}
+
+/* numValue converts the len digits of s to an int,
+   returns false if the value does not fit */
+/* numValue将s中的len个数字转换为int，超出范围时返回false */
+static bool numValue(const char *s, int len, int *val) {
+    uint64_t v = 0;
+    /* 跳过前导0 */
+    while (len > 0 && *s == '0') {
+        s++;
+        len--;
+    }
+    /* INT_MAX只有10位 */
+    if (len > 10) {
+        *val = INT_MAX;
+        return false;
+    }
+    if (len >= 8) {
+        v = parseEightDigits(s);
+        s += 8;
+        len -= 8;
+    }
+    while (len-- > 0)
+        v = v * 10 + (uint64_t) (*s++ - '0');
+    if (v > INT_MAX) {
+        *val = INT_MAX;
+        return false;
+    }
+    *val = (int) v;
+    return true;
+}
+
+/* countErrors adds the errors found while scanning
+   token to the error count */
+/* countErrors将扫描token时发现的错误计入错误数 */
+static void countErrors(TinyScanner *sc, TokenType token) {
+    switch (token) {
+        case ERROR:
+            sc->errors++;
+            break;
+        case NUM:
+        case FNUM:
+            if (sc->NumOverflow)
+                sc->errors++;
+            break;
+        case STR:
+            if (sc->StringStraddle)
+                sc->errors++;
+            break;
+        case ENDFILE:
+            sc->errors += !sc->StringOver + sc->StringStraddle + !sc->CommentOver;
+            break;
+        default:
+            break;
+    }
+}
+
+/* hasError tells whether token comes with an error
+   that printErrors reports */
+/* hasError判断token是否带有printErrors要报告的错误 */
+static bool hasError(const TinyScanner *sc, TokenType token) {
+    switch (token) {
+        case ERROR:
+            return true;
+        case ENDFILE:
+            return !sc->StringOver || sc->StringStraddle || !sc->CommentOver;
+        case NUM:
+        case FNUM:
+            return sc->NumOverflow;
+        case STR:
+            return sc->StringStraddle;
+        default:
+            return false;
+    }
+}
+
+/* printErrors reports the errors found while scanning
+   token after its line in the listing; traced tells
+   whether the token itself was listed */
+/* printErrors在列表中token所在行之后报告扫描token时发现的错误；
+   traced表示token本身是否已列出 */
+static void printErrors(TinyScanner *sc, TokenType token, bool traced) {
+    FILE *listing = sc->listing;
+    /* 未列出token且没有错误时不输出任何内容 */
+    if (!traced && !hasError(sc, token))
+        return;
+#ifndef _WIN32
+    /* 批量中的回显行先写出，错误才跟在它所指的行之后 */
+    if (sc->echo != NULL)
+        flushEcho(sc);
+#endif
+    switch (token) {
+        case ERROR:
+            /* 未列出token时，非法字符也要报告 */
+            if (!traced)
+                fprintf(listing, "\t%d: ERROR: %s\n", sc->lineno, sc->tokenString);
+            break;
+        case ENDFILE:
+            /*字符串是否闭合*/
+            if (!sc->StringOver)
+                fprintf(listing, "\nError, the line %d of string right quote match error.", sc->StringLine);
+            /*字符串是否跨行*/
+            if (sc->StringStraddle)
+                fprintf(listing, "\nError, string straddle between line %d and line %d!", sc->StringLine, sc->lineno);
+            /*注释是否闭合*/
+            if (!sc->CommentOver)
+                fprintf(listing, "\nError, the line %d of comment right parenthesis matching error.", sc->CommentLine);
+            fprintf(listing, "\n");
+            break;
+        case NUM:
+        case FNUM:
+            /*是否溢出*/
+            if (sc->NumOverflow)
+                fprintf(listing, "\tError, the line %d of number out of range!\n", sc->lineno);
+            break;
+        case STR:
+            /*是否跨行*/
+            if (sc->StringStraddle)
+                fprintf(listing, "\tError, string straddle between line %d and line %d!\n", sc->StringLine, sc->lineno);
+            break;
+        default:
+            break;
+    }
+}
+
 /****************************************/
 /* the primary function of the scanner  */
 /****************************************/
@@ -115,90 +475,62 @@ static TokenType reservedLookup(char *s) {
  * next token in source file
  * 函数getToken返回源文件中的下一个token
  */
-TokenType getToken(void) { /* index for storing into tokenString */
+TokenType getToken(TinyScanner *sc) { /* index for storing into sc->tokenString */
     int tokenStringIndex = 0;
     /* holds current token to be returned */
     TokenType currentToken;
     /* current state - always begins at START */
     StateType state = START;
-    /* flag to indicate save to tokenString */
+    /* flag to indicate save to sc->tokenString */
     /* 指示保存到tokenString的标志，即是否保存该字符 */
     bool save;
     /* state一定要转到done才结束 */
     while (state != DONE) {
-        int c = getNextChar();
-        char ch = (char) c;
+        int c;
+        /* 记录token起始位置 */
+        if (state == START)
+            sc->tokenStart = sc->pos;
+        c = getNextChar(sc);
+        int cls = classOf(c);
         save = true;
         /* 查看状态转换图 */
         switch (state) {
             case START:
-                if (isdigit(c))
+                if (cls & CC_DIGIT)
                     state = INNUM;
-                    /* isalpha判断是否是英文字母 */
-                else if (isalpha(c))
+                else if (cls & CC_ALPHA)
                     state = INID;
-                else if (c == ':')
+                else if (cls & CC_SPACE)
+                    save = false;
+                else if (cls & CC_SINGLE) {
+                    state = DONE;
+                    currentToken = (TokenType) charClass[c].tok;
+                } else if (c == ':')
                     state = INASSIGN;
                 else if (c == '>')
                     state = INME;
                 else if (c == '<')
                     state = INLE;
-                else if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'))
-                    save = false;
                 else if (c == '{') {
                     save = false;
                     state = INCOMMENT;
-                    CommentOver = false;
-                    CommentLine = lineno;
+                    sc->CommentOver = false;
+                    sc->CommentLine = sc->lineno;
                 } else if (c == '\'') {
                     save = false;
                     state = INSTRING;
                     currentToken = STR;
-                    StringOver = false;
-                    StringLine = lineno;
+                    sc->StringOver = false;
+                    sc->StringLine = sc->lineno;
+                } else if (c == EOF) {
+                    save = false;
+                    state = DONE;
+                    currentToken = ENDFILE;
                 } else {
-                    /* other */
+                    /* 不识别其他字符 */
                     state = DONE;
-                    switch (c) {
-                        case EOF:
-                            save = false;
-                            currentToken = ENDFILE;
-                            break;
-                        case '=':
-                            currentToken = EQ;
-                            break;
-                        case '+':
-                            currentToken = PLUS;
-                            break;
-                        case '-':
-                            currentToken = MINUS;
-                            break;
-                        case '*':
-                            currentToken = TIMES;
-                            break;
-                        case '/':
-                            currentToken = OVER;
-                            break;
-                        case '(':
-                            currentToken = LPAREN;
-                            break;
-                        case ')':
-                            currentToken = RPAREN;
-                            break;
-                        case ';':
-                            currentToken = SEMI;
-                            break;
-                        case ',':
-                            currentToken = COMMA;
-                            break;
-                        case '%':
-                            currentToken = PERCENT;
-                            break;
-                        default:
-                            /* 不识别其他字符 */
-                            currentToken = ERROR;
-                            break;
-                    }
+                    currentToken = ERROR;
+                    sc->errorCode = TINY_DIAG_CHAR;
                 }
                 break;
             case INCOMMENT:
@@ -209,30 +541,31 @@ TokenType getToken(void) { /* index for storing into tokenString */
                     currentToken = ENDFILE;
                 } else if (c == '}') {
                     state = START;
-                    CommentOver = true;
+                    sc->CommentOver = true;
                 }
                 break;
             case INSTRING:
                 if (c == '\'') {
                     save = false;
                     state = DONE;
-                    StringOver = true;
+                    sc->StringOver = true;
                 } else if (c == EOF) {
                     state = DONE;
                     currentToken = ENDFILE;
                 }
-                if (StringLine != lineno)
-                    StringStraddle = true;
+                if (sc->StringLine != sc->lineno)
+                    sc->StringStraddle = true;
                 break;
             case INASSIGN:
                 state = DONE;
                 if (c == '=')
                     currentToken = ASSIGN;
                 else { /* backup in the input 在输入中备份，:=要连续*/
-                    /* ungetNextChar在lineBuf中回溯一个字符 */
-                    ungetNextChar();
+                    /* ungetNextChar在源程序中回溯一个字符 */
+                    ungetNextChar(sc);
                     save = false;
                     currentToken = ERROR;
+                    sc->errorCode = TINY_DIAG_ASSIGN;
                 }
                 break;
                 /* <= */
@@ -241,7 +574,7 @@ TokenType getToken(void) { /* index for storing into tokenString */
                 if (c == '=')
                     currentToken = LE;
                 else {
-                    ungetNextChar();
+                    ungetNextChar(sc);
                     save = false;
                     currentToken = LT;
                 }
@@ -252,26 +585,81 @@ TokenType getToken(void) { /* index for storing into tokenString */
                 if (c == '=')
                     currentToken = ME;
                 else {
-                    ungetNextChar();
+                    ungetNextChar(sc);
                     save = false;
                     currentToken = MT;
                 }
                 break;
             case INNUM:
-                if (isalpha(c)) {
-                    separate = true;
+                if (c == '.')
+                    state = INFRAC;
+                else if ((c == 'e') || (c == 'E'))
+                    state = INEXP;
+                else if (cls & CC_ALPHA) {
+                    sc->separate = true;
                     state = INID;
-                } else if (!isdigit(c)) { /* backup in the input */
-                    ungetNextChar();
+                } else if (!(cls & CC_DIGIT)) { /* backup in the input */
+                    ungetNextChar(sc);
                     save = false;
                     state = DONE;
                     currentToken = NUM;
                 }
                 break;
+            case INFRAC:
+                if ((c == 'e') || (c == 'E'))
+                    state = INEXP;
+                else if (cls & CC_ALPHA) {
+                    sc->separate = true;
+                    state = INID;
+                } else if (!(cls & CC_DIGIT)) { /* backup in the input */
+                    ungetNextChar(sc);
+                    save = false;
+                    state = DONE;
+                    currentToken = FNUM;
+                }
+                break;
+            case INEXP:
+                if ((c == '+') || (c == '-'))
+                    state = INEXPSIGN;
+                else if (cls & CC_DIGIT)
+                    state = INEXPNUM;
+                else if (cls & CC_ALPHA) {
+                    sc->separate = true;
+                    state = INID;
+                } else { /* 指数缺少数字 */
+                    ungetNextChar(sc);
+                    save = false;
+                    state = DONE;
+                    currentToken = ERROR;
+                    sc->errorCode = TINY_DIAG_EXPONENT;
+                }
+                break;
+            case INEXPSIGN:
+                if (cls & CC_DIGIT)
+                    state = INEXPNUM;
+                else { /* 指数缺少数字 */
+                    ungetNextChar(sc);
+                    save = false;
+                    state = DONE;
+                    currentToken = ERROR;
+                    sc->errorCode = TINY_DIAG_EXPONENT;
+                }
+                break;
+            case INEXPNUM:
+                if (cls & CC_ALPHA) {
+                    sc->separate = true;
+                    state = INID;
+                } else if (!(cls & CC_DIGIT)) { /* backup in the input */
+                    ungetNextChar(sc);
+                    save = false;
+                    state = DONE;
+                    currentToken = FNUM;
+                }
+                break;
             case INID:
                 /*字符必须是字母或者是数字*/
-                if (!(isalpha(c) || isdigit(c))) { /* backup in the input */
-                    ungetNextChar();
+                if (!(cls & (CC_ALPHA | CC_DIGIT))) { /* backup in the input */
+                    ungetNextChar(sc);
                     save = false;
                     state = DONE;
                     currentToken = ID;
@@ -279,32 +667,383 @@ TokenType getToken(void) { /* index for storing into tokenString */
                 break;
             case DONE:
             default: /* should never happen */
-                fprintf(listing, "Scanner Bug: state= %d\n", state);
+                fprintf(sc->listing, "Scanner Bug: state= %d\n", state);
                 state = DONE;
                 currentToken = ERROR;
                 break;
         }
         if ((save) && (tokenStringIndex <= MAXTOKENLEN))
-            tokenString[tokenStringIndex++] = (char) c;
+            sc->tokenString[tokenStringIndex++] = (char) c;
         if (state == DONE) {
-            tokenString[tokenStringIndex] = '\0';
+            sc->tokenString[tokenStringIndex] = '\0';
             /*检验是否是关键字*/
             if (currentToken == ID)
-                currentToken = reservedLookup(tokenString);
+                currentToken = reservedLookup(sc->tokenString);
+            /*转换数值*/
+            else if (currentToken == NUM && !numValue(sc->tokenString, tokenStringIndex, &sc->tokenValue))
+                sc->NumOverflow = true;
+            else if (currentToken == FNUM && !floatValue(sc->tokenString, &sc->tokenFloat))
+                sc->NumOverflow = true;
             /*分隔符*/
-            if (separate) {
+            if (sc->separate) {
                 currentToken = ERROR;
-                separate = false;
+                sc->errorCode = TINY_DIAG_SEPARATE;
+                sc->separate = false;
             }
+            countErrors(sc, currentToken);
+            /* 字符串内容为两个引号之间的源程序 */
+            if (sc->pool != NULL)
+                sc->literal = currentToken == STR
+                              ? poolIntern(sc->pool, sc->buf + sc->tokenStart + 1, sc->pos - sc->tokenStart - 2)
+                              : -1;
         }
     }
-    if (TraceScan) {
+    /* 块的末尾不是源程序的末尾，其ENDFILE不记录也不列出 */
+    if (currentToken == ENDFILE && sc->partial) {
+#ifndef _WIN32
+        if (sc->echo != NULL)
+            flushEcho(sc);
+#endif
+        return currentToken;
+    }
+    if (tracing(sc, trace))
+        traceToken(sc, currentToken);
+    if (sc->diags != NULL)
+        diagnose(sc, currentToken);
+    /* 收集诊断时错误不写入列表，而在最后统一输出 */
+    if (tracing(sc, TraceScan) && (sc->diags == NULL || currentToken != ERROR)) {
         if (currentToken == ENDFILE) {
-            if (lineBuf[bufsize - 1] != '\n')
-                fprintf(listing, "\n%d: ", ++lineno);
+            if (sc->len == 0 || sc->buf[sc->len - 1] != '\n')
+                fprintf(sc->listing, "\n%d: ", ++sc->lineno);
         } else
-            fprintf(listing, "\t%d: ", lineno);
-        printToken(currentToken, tokenString);
-    }
+            fprintf(sc->listing, "\t%d: ", sc->lineno);
+        printToken(sc->listing, currentToken, sc->tokenString);
+        if (sc->diags == NULL)
+            printErrors(sc, currentToken, true);
+        else if (currentToken == ENDFILE)
+            fprintf(sc->listing, "\n");
+    } else if (sc->listing != NULL && sc->diags == NULL)
+        /* 错误报告不是跟踪点，不跟踪时也输出 */
+        printErrors(sc, currentToken, false);
+#ifndef _WIN32
+    if (currentToken == ENDFILE && sc->echo != NULL)
+        flushEcho(sc);
+#endif
+    /* 错误已报告 */
+    if (currentToken == STR || currentToken == ENDFILE)
+        sc->StringStraddle = false;
+    sc->NumOverflow = false;
     return currentToken;
 } /* end getToken */
+
+/****************************************/
+/*   the public interface of the library */
+/****************************************/
+
+/* newScanner allocates a scanner over len bytes of buf */
+/* newScanner分配buf中len个字节的扫描器 */
+static TinyScanner *newScanner(const char *buf, size_t len, unsigned flags, FILE *listing) {
+    TinyScanner *sc = (TinyScanner *) calloc(1, sizeof(TinyScanner));
+    if (sc == NULL)
+        return NULL;
+    countAlloc(ALLOC_SCANNER, sizeof(TinyScanner));
+    sc->buf = buf;
+    sc->len = len;
+    sc->listing = listing;
+    /* 没有列表文件时不回显也不跟踪 */
+    sc->EchoSource = listing != NULL && (flags & TINY_ECHO_SOURCE);
+    sc->TraceScan = listing != NULL && (flags & TINY_TRACE_SCAN);
+    sc->StringOver = true;
+    sc->CommentOver = true;
+    sc->literal = -1;
+    if (flags & TINY_STRING_POOL) {
+        sc->pool = poolNew();
+        if (sc->pool == NULL) {
+            free(sc);
+            return NULL;
+        }
+    }
+    if (flags & TINY_DIAGNOSTICS) {
+        sc->diags = diagNew();
+        if (sc->diags == NULL) {
+            poolFree(sc->pool);
+            free(sc);
+            return NULL;
+        }
+    }
+#ifndef TINY_NO_TRACE
+    if (flags & TINY_TRACE_BINARY) {
+        sc->trace = (TraceRing *) malloc(sizeof(TraceRing));
+        if (sc->trace == NULL) {
+            diagFree(sc->diags);
+            poolFree(sc->pool);
+            free(sc);
+            return NULL;
+        }
+        countAlloc(ALLOC_SCANNER, sizeof(TraceRing));
+        sc->trace->head = 0;
+        sc->trace->tail = 0;
+        sc->trace->epoch = traceClock();
+    }
+#endif
+#if !defined(_WIN32) && !defined(TINY_NO_TRACE)
+    /* 只回显不跟踪时，列表全部由源程序行组成，可以用writev批量写出 */
+    if (sc->EchoSource && !sc->TraceScan && fileno(listing) >= 0) {
+        sc->echo = (EchoBatch *) malloc(sizeof(EchoBatch));
+        if (sc->echo != NULL) {
+            countAlloc(ALLOC_SCANNER, sizeof(EchoBatch));
+            sc->echo->fd = fileno(listing);
+            sc->echo->lines = 0;
+        }
+    }
+#endif
+    return sc;
+}
+
+TinyScanner *tinyOpenBuffer(const char *buf, size_t len, unsigned flags, FILE *listing) {
+    return newScanner(buf, len, flags, listing);
+}
+
+TinyScanner *tinyOpenFile(const char *path, unsigned flags, FILE *listing) {
+    FILE *f;
+    char *buf = NULL;
+    size_t len = 0;
+    size_t cap = 0;
+    size_t n;
+    TinyScanner *sc;
+#ifndef _WIN32
+    /* 普通文件直接映射，不复制 */
+    int fd = open(path, O_RDONLY);
+    struct stat sb;
+    if (fd >= 0 && fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+        void *map = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            close(fd);
+            sc = newScanner((const char *) map, (size_t) sb.st_size, flags, listing);
+            if (sc == NULL)
+                munmap(map, (size_t) sb.st_size);
+            else {
+                sc->mapped = true;
+                madvise(map, (size_t) sb.st_size, MADV_SEQUENTIAL);
+            }
+            return sc;
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+#endif
+    f = fopen(path, "r");
+    if (f == NULL)
+        return NULL;
+    /* 读入整个文件 */
+    do {
+        if (len == cap) {
+            char *t = (char *) realloc(buf, cap = cap ? 2 * cap : 65536);
+            if (t == NULL) {
+                free(buf);
+                fclose(f);
+                return NULL;
+            }
+            countAlloc(ALLOC_SCANNER, cap);
+            buf = t;
+        }
+        n = fread(buf + len, 1, cap - len, f);
+        len += n;
+    } while (n > 0);
+    fclose(f);
+    sc = newScanner(buf, len, flags, listing);
+    if (sc == NULL)
+        free(buf);
+    else
+        sc->owned = buf;
+    return sc;
+}
+
+TinyTokenType tinyNextToken(TinyScanner *scanner) {
+    return (TinyTokenType) getToken(scanner);
+}
+
+const char *tinyTokenString(const TinyScanner *scanner) {
+    return scanner->tokenString;
+}
+
+int tinyTokenLine(const TinyScanner *scanner) {
+    return scanner->lineno;
+}
+
+int tinyTokenValue(const TinyScanner *scanner) {
+    return scanner->tokenValue;
+}
+
+double tinyTokenFloat(const TinyScanner *scanner) {
+    return scanner->tokenFloat;
+}
+
+int tinyTokenLiteral(const TinyScanner *scanner) {
+    return scanner->literal;
+}
+
+int tinyLiteralCount(const TinyScanner *scanner) {
+    return scanner->pool != NULL ? poolCount(scanner->pool) : 0;
+}
+
+const char *tinyLiteral(const TinyScanner *scanner, int index, size_t *len) {
+    return scanner->pool != NULL ? poolString(scanner->pool, index, len) : NULL;
+}
+
+size_t tinyTokenOffset(const TinyScanner *scanner) {
+    return scanner->tokenStart;
+}
+
+/* countNewlines counts the newlines in len bytes of p,
+   eight bytes at a time */
+/* countNewlines统计p中len个字节里的换行符，每次处理8个字节 */
+static size_t countNewlines(const char *p, size_t len) {
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t x;
+        memcpy(&x, p + i, sizeof(x));
+        /* 等于'\n'的字节变为0，再把每个0字节的最高位置1 */
+        x ^= ones * '\n';
+        x = ~(((x & low7) + low7) | x) & ~low7;
+#if defined(__GNUC__)
+        count += (size_t) __builtin_popcountll(x);
+#else
+        /* 每个字节至多一位，乘法把各字节之和累加到最高字节 */
+        count += (size_t) (((x >> 7) * ones) >> 56);
+#endif
+    }
+    for (; i < len; i++)
+        count += p[i] == '\n';
+    return count;
+}
+
+/* buildLineIndex records where every line starts */
+/* buildLineIndex记录每一行的起始位置 */
+static bool buildLineIndex(TinyScanner *sc) {
+    const char *p = sc->buf;
+    const char *end = sc->buf + sc->len;
+    size_t size;
+    int n = 0;
+    if (sc->lineStarts != NULL)
+        return true;
+    size = (countNewlines(sc->buf, sc->len) + 1) * sizeof(size_t);
+    sc->lineStarts = (size_t *) malloc(size);
+    if (sc->lineStarts == NULL)
+        return false;
+    countAlloc(ALLOC_SCANNER, size);
+    sc->lineStarts[n++] = 0;
+    while (p < end && (p = memchr(p, '\n', (size_t) (end - p))) != NULL)
+        sc->lineStarts[n++] = (size_t) (++p - sc->buf);
+    sc->lineCount = n;
+    return true;
+}
+
+int tinyLocate(TinyScanner *scanner, size_t offset, int *line, int *column) {
+    int lo = 0;
+    int hi;
+    if (offset > scanner->len || !buildLineIndex(scanner))
+        return 0;
+    /* 二分查找最后一个不大于offset的行首 */
+    hi = scanner->lineCount - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (scanner->lineStarts[mid] <= offset)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    *line = lo + 1;
+    *column = (int) (offset - scanner->lineStarts[lo]) + 1;
+    return 1;
+}
+
+const char *tinyLineText(TinyScanner *scanner, int line, size_t *len) {
+    size_t start;
+    size_t end;
+    if (line < 1 || !buildLineIndex(scanner) || line > scanner->lineCount)
+        return NULL;
+    start = scanner->lineStarts[line - 1];
+    end = line < scanner->lineCount ? scanner->lineStarts[line] - 1 : scanner->len;
+    *len = end - start;
+    return scanner->buf + start;
+}
+
+int tinyErrorCount(const TinyScanner *scanner) {
+    return scanner->errors;
+}
+
+/* flags of a checkpoint */
+/* 检查点的标志 */
+#define CP_EOF       0x01
+#define CP_STRING    0x02 /* StringOver */
+#define CP_COMMENT   0x04 /* CommentOver */
+#define CP_STRADDLE  0x08
+#define CP_OVERFLOW  0x10
+#define CP_SEPARATE  0x20
+
+void tinySave(const TinyScanner *scanner, TinyCheckpoint *checkpoint) {
+    checkpoint->pos = scanner->pos;
+    checkpoint->lineEnd = scanner->lineEnd;
+    checkpoint->lineno = scanner->lineno;
+    checkpoint->errors = scanner->errors;
+    checkpoint->commentLine = scanner->CommentLine;
+    checkpoint->stringLine = scanner->StringLine;
+    checkpoint->flags = (scanner->EOF_flag ? CP_EOF : 0) | (scanner->StringOver ? CP_STRING : 0)
+                        | (scanner->CommentOver ? CP_COMMENT : 0) | (scanner->StringStraddle ? CP_STRADDLE : 0)
+                        | (scanner->NumOverflow ? CP_OVERFLOW : 0) | (scanner->separate ? CP_SEPARATE : 0);
+    checkpoint->diags = 0;
+    checkpoint->merged = 0;
+    checkpoint->stopped = 0;
+    if (scanner->diags != NULL)
+        diagSave(scanner->diags, checkpoint);
+}
+
+void tinyRestore(TinyScanner *scanner, const TinyCheckpoint *checkpoint) {
+    scanner->pos = checkpoint->pos;
+    scanner->lineEnd = checkpoint->lineEnd;
+    scanner->lineno = checkpoint->lineno;
+    scanner->errors = checkpoint->errors;
+    scanner->CommentLine = checkpoint->commentLine;
+    scanner->StringLine = checkpoint->stringLine;
+    scanner->EOF_flag = (checkpoint->flags & CP_EOF) != 0;
+    scanner->StringOver = (checkpoint->flags & CP_STRING) != 0;
+    scanner->CommentOver = (checkpoint->flags & CP_COMMENT) != 0;
+    scanner->StringStraddle = (checkpoint->flags & CP_STRADDLE) != 0;
+    scanner->NumOverflow = (checkpoint->flags & CP_OVERFLOW) != 0;
+    scanner->separate = (checkpoint->flags & CP_SEPARATE) != 0;
+    if (scanner->diags != NULL)
+        diagRestore(scanner->diags, checkpoint);
+}
+
+size_t tinyTraceRead(TinyScanner *scanner, TinyTraceEvent *events, size_t max) {
+    TraceRing *r = scanner->trace;
+    size_t n = 0;
+    if (r == NULL)
+        return 0;
+    while (n < max && r->tail != r->head)
+        events[n++] = r->ev[r->tail++ & (TRACERING - 1)];
+    return n;
+}
+
+void tinyClose(TinyScanner *scanner) {
+    if (scanner != NULL) {
+#ifndef _WIN32
+        if (scanner->echo != NULL) {
+            flushEcho(scanner);
+            free(scanner->echo);
+        }
+        if (scanner->mapped)
+            munmap((void *) scanner->buf, scanner->len);
+#endif
+        free(scanner->owned);
+        free(scanner->lineStarts);
+        free(scanner->trace);
+        poolFree(scanner->pool);
+        diagFree(scanner->diags);
+        free(scanner);
+    }
+}
@@ -10,16 +10,76 @@
 
 /* MAXTOKENLEN is the maximum size of a token */
 /* token的最大数目 */
-#define MAXTOKENLEN 255
+#define MAXTOKENLEN TINY_MAXTOKENLEN
 
-/* tokenString array stores the lexeme of each token */
-/* tokenString数组存储每个token的词素 */
-extern char tokenString[MAXTOKENLEN + 1];
+/* batched echo output, defined in scan.c */
+/* 批量回显输出，在scan.c中定义 */
+typedef struct EchoBatch EchoBatch;
 
-/* function getToken returns the 
+/* string literal pool, defined in strpool.h */
+/* 字符串字面量池，在strpool.h中定义 */
+typedef struct StringPool StringPool;
+
+/* collected diagnostics, defined in diag.c */
+/* 收集的诊断，在diag.c中定义 */
+typedef struct Diagnostics Diagnostics;
+
+/* ring of binary trace events, defined in scan.c */
+/* 二进制跟踪事件环，在scan.c中定义 */
+typedef struct TraceRing TraceRing;
+
+/* struct TinyScanner holds everything one scan of a
+ * source needs, so that scanners never share state
+ * TinyScanner保存一次扫描所需的全部状态，扫描器之间不共享状态
+ */
+struct TinyScanner {
+    const char *buf;    /* source text */
+    size_t len;         /* size of the source text */
+    size_t pos;         /* position of the next character */
+    size_t lineEnd;     /* end of the current line */
+    char *owned;        /* source text freed by tinyClose */
+    bool mapped;        /* source text is a mapping unmapped by tinyClose */
+    size_t dropped;     /* mapped pages before this offset were dropped */
+    bool EOF_flag;      /* corrects ungetNextChar behavior on EOF */
+    bool partial;       /* the source goes on past len, see tinyOpenChunk */
+    int lineno;         /* source line number for listing */
+    FILE *listing;      /* listing output text file */
+    bool EchoSource;    /* echo source lines to listing */
+    bool TraceScan;     /* print tokens to listing */
+    EchoBatch *echo;    /* echo lines not yet written, or NULL */
+    TraceRing *trace;   /* binary trace events, or NULL */
+    StringPool *pool;   /* pooled string literals, or NULL */
+    int literal;        /* pool index of the last STR token, or -1 */
+    Diagnostics *diags; /* collected diagnostics, or NULL */
+    int errorCode;      /* TinyDiagCode of the last ERROR token */
+    int errors;         /* number of errors found */
+    size_t *lineStarts; /* offsets of line starts, built on demand */
+    int lineCount;      /* number of entries in lineStarts */
+
+    /* tokenString array stores the lexeme of each token */
+    /* tokenString数组存储每个token的词素 */
+    char tokenString[MAXTOKENLEN + 1];
+    int tokenValue;     /* value of the last NUM token */
+    double tokenFloat;  /* value of the last FNUM token */
+    size_t tokenStart;  /* offset of the first character of the last token */
+
+    int CommentLine;    /*指示comment的行数*/
+    int StringLine;     /*指示string的行数*/
+    /*true指示string和comment闭合*/
+    bool StringOver;
+    bool CommentOver;
+    /*True指示string跨行*/
+    bool StringStraddle;
+    /*True指示NUM超出int范围或FNUM超出double范围*/
+    bool NumOverflow;
+    /*true指示id，num和keyword之间有空白符*/
+    bool separate;
+};
+
+/* function getToken returns the
  * next token in source file
  * 函数getToken返回源文件中的下一个token
  */
-TokenType getToken(void);
+TokenType getToken(TinyScanner *scanner);
 
 #endif
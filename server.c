@@ -0,0 +1,304 @@
+/****************************************************/
+/* File: server.c                                   */
+/* Compile-server implementation for the TINY       */
+/* compiler                                         */
+/* 常驻编译服务的实现                               */
+/****************************************************/
+
+#include "globals.h"
+#include "server.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+/* OUTBUFLEN = size of the listing buffer that is
+   flushed to the client as the listing grows */
+/* OUTBUFLEN =列表缓冲区的大小，列表增长时分块发送给客户端 */
+#define OUTBUFLEN 65536
+
+/* REQLINELEN = longest line of a request header */
+/* REQLINELEN =请求头中一行的最大长度 */
+#define REQLINELEN 4096
+
+/* MAXWORKERS bounds the number of worker threads */
+/* MAXWORKERS =工作线程数的上限 */
+#define MAXWORKERS 64
+
+/* a worker thread and the buffers it keeps warm
+   across requests */
+/* 工作线程及其在请求之间复用的缓冲区 */
+typedef struct {
+    pthread_t thread;
+    int listenFd;
+    int timeout;       /* seconds to wait on an idle client, 0 for no limit */
+    char outBuf[OUTBUFLEN];
+    char *srcBuf;
+    size_t srcBufSize;
+} Worker;
+
+/* readLine reads one header line without its newline */
+/* readLine读取一行请求头并去掉换行符 */
+static bool readLine(FILE *in, char *line) {
+    size_t n;
+    if (fgets(line, REQLINELEN, in) == NULL)
+        return false;
+    n = strlen(line);
+    if (n > 0 && line[n - 1] == '\n')
+        line[--n] = '\0';
+    return true;
+}
+
+/* timedOut tells whether reading in failed because the
+   client sent nothing within the timeout */
+/* timedOut判断in的读取失败是否因为客户端在超时时间内没有发送数据 */
+static bool timedOut(FILE *in) {
+    return ferror(in) && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+/* readRequest reads a request and its source text into
+   the worker's buffer, returns the length of the text,
+   or (size_t) -1 after answering ERR */
+/* readRequest将请求及其源程序读入工作线程的缓冲区，返回源程序长度，
+   失败时回复ERR并返回(size_t) -1 */
+static size_t readRequest(Worker *w, FILE *in, FILE *out, char *name) {
+    char line[REQLINELEN];
+    char kind[REQLINELEN];
+    FILE *src;
+    size_t len;
+    if (!readLine(in, kind) || !readLine(in, name) || !readLine(in, line)) {
+        fprintf(out, timedOut(in) ? "ERR Timed out\n" : "ERR Malformed request\n");
+        return (size_t) -1;
+    }
+    if (!strcmp(kind, "FILE")) {
+        src = fopen(line, "r");
+        if (src == NULL) {
+            fprintf(out, "ERR File %s not found\n", name);
+            return (size_t) -1;
+        }
+        len = readSource(src, &w->srcBuf, &w->srcBufSize);
+        fclose(src);
+        if (len == (size_t) -1)
+            fprintf(out, "ERR Out of memory\n");
+        return len;
+    }
+    if (strcmp(kind, "BUF") != 0) {
+        fprintf(out, "ERR Unknown request %s\n", kind);
+        return (size_t) -1;
+    }
+    len = (size_t) strtoul(line, NULL, 10);
+    if (len > w->srcBufSize) {
+        char *t = (char *) realloc(w->srcBuf, len);
+        if (t == NULL) {
+            fprintf(out, "ERR Out of memory\n");
+            return (size_t) -1;
+        }
+        w->srcBuf = t;
+        w->srcBufSize = len;
+    }
+    if (fread(w->srcBuf, 1, len, in) != len) {
+        fprintf(out, timedOut(in) ? "ERR Timed out\n" : "ERR Short buffer\n");
+        return (size_t) -1;
+    }
+    return len;
+}
+
+/* serveRequest answers one request on conn */
+/* serveRequest处理conn上的一个请求 */
+static void serveRequest(Worker *w, int conn) {
+    char name[REQLINELEN];
+    size_t len;
+    FILE *in = fdopen(dup(conn), "r");
+    FILE *out = fdopen(dup(conn), "w");
+    if (in == NULL || out == NULL) {
+        if (in != NULL)
+            fclose(in);
+        if (out != NULL)
+            fclose(out);
+        return;
+    }
+    setvbuf(out, w->outBuf, _IOFBF, OUTBUFLEN);
+    len = readRequest(w, in, out, name);
+    if (len != (size_t) -1) {
+        fprintf(out, "OK\n");
+        compile(name, w->srcBuf, len, out);
+    }
+    fclose(out);
+    fclose(in);
+}
+
+/* workerLoop accepts and serves connections until
+   accept fails */
+/* workerLoop接受并处理连接，直到accept失败 */
+static void *workerLoop(void *arg) {
+    Worker *w = (Worker *) arg;
+    for (;;) {
+        int conn = accept(w->listenFd, NULL, NULL);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            perror("accept");
+            break;
+        }
+        /* 空闲或不再读取列表的客户端不能一直占用工作线程 */
+        if (w->timeout > 0) {
+            struct timeval tv;
+            tv.tv_sec = w->timeout;
+            tv.tv_usec = 0;
+            setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(conn, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        }
+        serveRequest(w, conn);
+        close(conn);
+    }
+    return NULL;
+}
+
+/* makeAddress fills addr with the socket path */
+/* makeAddress用socket路径填充addr */
+static bool makeAddress(struct sockaddr_un *addr, const char *path) {
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Socket path %s too long\n", path);
+        return false;
+    }
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+int runServer(const char *path) {
+    struct sockaddr_un addr;
+    char *timeoutEnv = getenv(TIMEOUT_ENV);
+    int timeout = timeoutEnv ? atoi(timeoutEnv) : SERVER_DEFAULT_TIMEOUT;
+    Worker *workers;
+    int nworkers;
+    int fd;
+    int i;
+    if (!makeAddress(&addr, path))
+        return 1;
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        perror(path);
+        close(fd);
+        return 1;
+    }
+    /* 客户端提前断开时不终止服务器 */
+    signal(SIGPIPE, SIG_IGN);
+    nworkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (nworkers < 1)
+        nworkers = 1;
+    if (nworkers > MAXWORKERS)
+        nworkers = MAXWORKERS;
+    workers = (Worker *) calloc((size_t) nworkers, sizeof(Worker));
+    if (workers == NULL) {
+        fprintf(stderr, "Out of memory error\n");
+        close(fd);
+        return 1;
+    }
+    fprintf(stderr, "TINY server listening on %s with %d workers\n", path, nworkers);
+    /* 所有工作线程在同一个socket上accept */
+    for (i = 0; i < nworkers; i++) {
+        workers[i].listenFd = fd;
+        workers[i].timeout = timeout;
+        if (pthread_create(&workers[i].thread, NULL, workerLoop, &workers[i]) != 0)
+            break;
+    }
+    while (i-- > 0)
+        pthread_join(workers[i].thread, NULL);
+    free(workers);
+    close(fd);
+    unlink(path);
+    return 1;
+}
+
+/* writeAll writes all n bytes of buf to fd */
+/* writeAll将buf中的n个字节全部写入fd */
+static bool writeAll(int fd, const char *buf, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, buf, n);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        buf += w;
+        n -= (size_t) w;
+    }
+    return true;
+}
+
+int runClient(const char *path, const char *pgm) {
+    struct sockaddr_un addr;
+    char req[3 * REQLINELEN];
+    char cwd[REQLINELEN];
+    char buf[OUTBUFLEN];
+    char *body;
+    ssize_t n;
+    size_t have = 0;
+    int fd;
+    if (!makeAddress(&addr, path))
+        return -1;
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    /* 服务器的工作目录不同，相对路径要补全 */
+    if (pgm[0] == '/' || getcwd(cwd, sizeof(cwd)) == NULL)
+        snprintf(req, sizeof(req), "FILE\n%s\n%s\n", pgm, pgm);
+    else
+        snprintf(req, sizeof(req), "FILE\n%s\n%s/%s\n", pgm, cwd, pgm);
+    if (!writeAll(fd, req, strlen(req))) {
+        close(fd);
+        return -1;
+    }
+    shutdown(fd, SHUT_WR);
+    /* 先读取状态行 */
+    while ((body = memchr(buf, '\n', have)) == NULL && have < sizeof(buf)) {
+        n = read(fd, buf + have, sizeof(buf) - have);
+        if (n <= 0) {
+            close(fd);
+            return -1;
+        }
+        have += (size_t) n;
+    }
+    if (body == NULL || strncmp(buf, "OK\n", 3) != 0) {
+        if (body != NULL && !strncmp(buf, "ERR ", 4))
+            fwrite(buf + 4, 1, (size_t) (body + 1 - (buf + 4)), stderr);
+        close(fd);
+        return 1;
+    }
+    body++;
+    fwrite(body, 1, have - (size_t) (body - buf), stdout);
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+        fwrite(buf, 1, (size_t) n, stdout);
+    close(fd);
+    return 0;
+}
+
+#else
+
+int runServer(const char *path) {
+    fprintf(stderr, "Server mode is not supported on this platform\n");
+    return 1;
+}
+
+int runClient(const char *path, const char *pgm) {
+    return -1;
+}
+
+#endif
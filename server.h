@@ -0,0 +1,63 @@
+/****************************************************/
+/* File: server.h                                   */
+/* Compile-server mode for the TINY compiler        */
+/* 常驻编译服务模式                                 */
+/****************************************************/
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+/* SERVER_ENV names the environment variable holding
+ * the socket path of a running server; when it is set
+ * the command line forwards its request to that server
+ * SERVER_ENV是保存服务器socket路径的环境变量，
+ * 设置后命令行会把请求转发给该服务器
+ */
+#define SERVER_ENV "TINY_SERVER"
+
+/* TIMEOUT_ENV optionally sets the seconds a server
+ * waits on a client that sends or takes nothing, 0 for
+ * no limit
+ * TIMEOUT_ENV可选地设置服务器等待不发送也不接收数据的客户端的秒数，0表示不限
+ */
+#define TIMEOUT_ENV "TINY_SERVER_TIMEOUT"
+#define SERVER_DEFAULT_TIMEOUT 30
+
+/* Function compile runs the compiler over the len
+ * bytes of text and writes the listing for pgm to out
+ * (defined in main.c)
+ * 函数compile编译text中的len个字节并将pgm的列表写入out（在main.c中定义）
+ */
+void compile(const char *pgm, const char *text, size_t len, FILE *out);
+
+/* Function readSource reads the rest of f into *buf,
+ * growing it to capacity *cap as needed; it returns
+ * the number of bytes read, or (size_t) -1 when out of
+ * memory (defined in main.c)
+ * 函数readSource将f的剩余内容读入*buf，需要时扩大到容量*cap；
+ * 返回读取的字节数，内存不足时返回(size_t) -1（在main.c中定义）
+ */
+size_t readSource(FILE *f, char **buf, size_t *cap);
+
+/* Function runServer listens on the unix socket path
+ * and serves requests on worker threads until it
+ * fails; each request is
+ * FILE\n<name>\n<path>\n or BUF\n<name>\n<length>\n<bytes>
+ * and is answered with OK\n followed by the listing,
+ * or ERR <message>\n; a client idle for longer than
+ * the timeout is answered ERR Timed out\n and dropped
+ * 函数runServer在unix socket path上监听并由工作线程处理请求，
+ * 请求格式为FILE\n<name>\n<path>\n或BUF\n<name>\n<length>\n<bytes>，
+ * 回复OK\n加列表，或ERR <message>\n；空闲超过超时时间的客户端收到ERR Timed out\n后被断开
+ */
+int runServer(const char *path);
+
+/* Function runClient sends pgm to the server at path
+ * and copies the listing to stdout; it returns the
+ * exit status, or -1 if no server could be reached
+ * 函数runClient将pgm发送给path上的服务器并把列表复制到stdout，
+ * 返回退出状态，无法连接服务器时返回-1
+ */
+int runClient(const char *path, const char *pgm);
+
+#endif
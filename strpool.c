@@ -0,0 +1,147 @@
+/****************************************************/
+/* File: strpool.c                                  */
+/* String literal pool implementation               */
+/* 字符串字面量池的实现                             */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "strpool.h"
+
+/* a literal is text[start..start+len) of the arena,
+   followed by a NUL */
+/* 字面量为文本区中的text[start..start+len)，其后跟一个NUL */
+typedef struct {
+    size_t start;
+    size_t len;
+    uint32_t hash;
+} Literal;
+
+struct StringPool {
+    char *text;        /* arena of literal texts */
+    size_t used;
+    size_t cap;
+    Literal *lits;
+    int count;
+    int litCap;
+    int *slots;        /* open-addressing table of indexes, -1 if empty */
+    uint32_t mask;     /* number of slots - 1 */
+};
+
+/* hash is FNV-1a over the len bytes at s */
+/* hash为s处len个字节的FNV-1a哈希 */
+static uint32_t hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; i++)
+        h = (h ^ (unsigned char) s[i]) * 16777619u;
+    return h;
+}
+
+StringPool *poolNew(void) {
+    StringPool *pool = (StringPool *) calloc(1, sizeof(StringPool));
+    if (pool == NULL)
+        return NULL;
+    pool->slots = (int *) malloc(16 * sizeof(int));
+    if (pool->slots == NULL) {
+        free(pool);
+        return NULL;
+    }
+    memset(pool->slots, 0xFF, 16 * sizeof(int));
+    pool->mask = 15;
+    countAlloc(ALLOC_SCANNER, sizeof(StringPool) + 16 * sizeof(int));
+    return pool;
+}
+
+/* grow doubles the table and reinserts every literal */
+/* grow将表加倍并重新插入所有字面量 */
+static bool grow(StringPool *pool) {
+    uint32_t mask = 2 * pool->mask + 1;
+    int *slots = (int *) malloc(((size_t) mask + 1) * sizeof(int));
+    int i;
+    if (slots == NULL)
+        return false;
+    countAlloc(ALLOC_SCANNER, ((size_t) mask + 1) * sizeof(int));
+    memset(slots, 0xFF, ((size_t) mask + 1) * sizeof(int));
+    for (i = 0; i < pool->count; i++) {
+        uint32_t h = pool->lits[i].hash & mask;
+        while (slots[h] >= 0)
+            h = (h + 1) & mask;
+        slots[h] = i;
+    }
+    free(pool->slots);
+    pool->slots = slots;
+    pool->mask = mask;
+    return true;
+}
+
+int poolIntern(StringPool *pool, const char *s, size_t len) {
+    uint32_t hv = hash(s, len);
+    uint32_t h = hv & pool->mask;
+    Literal *lit;
+    int i;
+    while ((i = pool->slots[h]) >= 0) {
+        lit = &pool->lits[i];
+        if (lit->hash == hv && lit->len == len && memcmp(pool->text + lit->start, s, len) == 0)
+            return i;
+        h = (h + 1) & pool->mask;
+    }
+    /* 新字面量：表保持至多半满 */
+    if ((uint32_t) pool->count + 1 > (pool->mask + 1) / 2) {
+        if (!grow(pool))
+            return -1;
+        h = hv & pool->mask;
+        while (pool->slots[h] >= 0)
+            h = (h + 1) & pool->mask;
+    }
+    if (pool->count == pool->litCap) {
+        int cap = pool->litCap ? 2 * pool->litCap : 64;
+        Literal *t = (Literal *) realloc(pool->lits, (size_t) cap * sizeof(Literal));
+        if (t == NULL)
+            return -1;
+        countAlloc(ALLOC_SCANNER, (size_t) cap * sizeof(Literal));
+        pool->lits = t;
+        pool->litCap = cap;
+    }
+    if (pool->used + len + 1 > pool->cap) {
+        size_t cap = pool->cap ? 2 * pool->cap : 4096;
+        char *t;
+        while (cap < pool->used + len + 1)
+            cap *= 2;
+        t = (char *) realloc(pool->text, cap);
+        if (t == NULL)
+            return -1;
+        countAlloc(ALLOC_SCANNER, cap);
+        pool->text = t;
+        pool->cap = cap;
+    }
+    lit = &pool->lits[pool->count];
+    lit->start = pool->used;
+    lit->len = len;
+    lit->hash = hv;
+    memcpy(pool->text + pool->used, s, len);
+    pool->text[pool->used + len] = '\0';
+    pool->used += len + 1;
+    pool->slots[h] = pool->count;
+    return pool->count++;
+}
+
+int poolCount(const StringPool *pool) {
+    return pool->count;
+}
+
+const char *poolString(const StringPool *pool, int index, size_t *len) {
+    if (index < 0 || index >= pool->count)
+        return NULL;
+    *len = pool->lits[index].len;
+    return pool->text + pool->lits[index].start;
+}
+
+void poolFree(StringPool *pool) {
+    if (pool != NULL) {
+        free(pool->text);
+        free(pool->lits);
+        free(pool->slots);
+        free(pool);
+    }
+}
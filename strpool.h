@@ -0,0 +1,45 @@
+/****************************************************/
+/* File: strpool.h                                  */
+/* String literal pool for the TINY scanner         */
+/* 扫描器的字符串字面量池                           */
+/****************************************************/
+
+#ifndef _STRPOOL_H_
+#define _STRPOOL_H_
+
+/* a pool of distinct string literals, each with an
+ * index in the order it was first seen
+ * 互不相同的字符串字面量池，每个字面量按首次出现的顺序编号
+ */
+typedef struct StringPool StringPool;
+
+/* Function poolNew returns an empty pool, or NULL
+ * when out of memory
+ * 函数poolNew返回一个空池，内存不足时返回NULL
+ */
+StringPool *poolNew(void);
+
+/* Function poolIntern returns the index of the len
+ * bytes at s, adding them if they are new, or -1 when
+ * out of memory
+ * 函数poolIntern返回s处len个字节的编号，新字面量会被加入，内存不足时返回-1
+ */
+int poolIntern(StringPool *pool, const char *s, size_t len);
+
+/* Function poolCount returns the number of literals */
+/* 函数poolCount返回字面量的个数 */
+int poolCount(const StringPool *pool);
+
+/* Function poolString returns the NUL-terminated text
+ * of literal index and stores its length in len; it
+ * stays valid until the next poolIntern
+ * 函数poolString返回编号为index的字面量文本（以NUL结尾）并将长度存入len，
+ * 在下一次poolIntern之前有效
+ */
+const char *poolString(const StringPool *pool, int index, size_t *len);
+
+/* Procedure poolFree frees the pool */
+/* 过程poolFree释放池 */
+void poolFree(StringPool *pool);
+
+#endif
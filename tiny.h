@@ -0,0 +1,452 @@
+/****************************************************/
+/* File: tiny.h                                     */
+/* Public C interface of the TINY compiler library  */
+/* TINY编译器库的公共C接口                          */
+/****************************************************/
+
+#ifndef _TINY_H_
+#define _TINY_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define TINY_API __attribute__((visibility("default")))
+#else
+#define TINY_API
+#endif
+
+/* TINY_MAXTOKENLEN = the longest lexeme kept for a token */
+/* TINY_MAXTOKENLEN =保留的token词素的最大长度 */
+#define TINY_MAXTOKENLEN 255
+
+/* token kinds returned by tinyNextToken */
+/* tinyNextToken返回的token种类 */
+typedef enum
+/* book-keeping tokens */
+{
+    TINY_ENDFILE,
+    TINY_ERROR,
+    /* reserved words */
+    TINY_IF, TINY_THEN, TINY_ELSE, TINY_END, TINY_REPEAT, TINY_UNTIL, TINY_READ, TINY_WRITE,
+    TINY_TRUE, TINY_FALSE, TINY_OR, TINY_AND, TINY_NOT, TINY_INT, TINY_BOOL, TINY_STRING,
+    TINY_FLOAT, TINY_DOUBLE, TINY_DO, TINY_WHILE,
+    /* multicharacter tokens */
+    TINY_ID,
+    TINY_NUM,
+    TINY_FNUM,
+    TINY_STR,
+    /* special symbols */
+    TINY_ASSIGN,    /* := */
+    TINY_EQ,        /* = */
+    TINY_LT,        /* < */
+    TINY_PLUS,      /* + */
+    TINY_MINUS,     /* - */
+    TINY_TIMES,     /* * */
+    TINY_OVER,      /* / */
+    TINY_LPAREN,    /* ( */
+    TINY_RPAREN,    /* ) */
+    TINY_SEMI,      /* ; */
+    TINY_MT,        /* > */
+    TINY_LE,        /* <= */
+    TINY_ME,        /* >= */
+    TINY_COMMA,     /* , */
+    TINY_QUOTATION, /* ' */
+    TINY_PERCENT    /* % */
+} TinyTokenType;
+
+/* a scanner over one source text; scanners share no
+ * state, so each thread may use its own
+ * 一个源程序的扫描器；扫描器之间不共享状态，每个线程可以使用自己的扫描器
+ */
+typedef struct TinyScanner TinyScanner;
+
+/* flags for tinyOpenFile and tinyOpenBuffer */
+/* tinyOpenFile和tinyOpenBuffer的标志 */
+#define TINY_ECHO_SOURCE 0x1 /* echo each source line to the listing */
+#define TINY_TRACE_SCAN  0x2 /* print each token to the listing */
+#define TINY_TRACE_BINARY 0x4 /* record binary trace events, see tinyTraceRead */
+#define TINY_STRING_POOL 0x8 /* keep each distinct string literal once, see tinyTokenLiteral */
+#define TINY_DIAGNOSTICS 0x10 /* collect errors instead of listing them, see tinyPrintDiagnostics */
+
+/* Function tinyOpenFile reads the file at path and
+ * returns a scanner over it, or NULL if it cannot be
+ * read; listing receives the echo/trace output and may
+ * be NULL
+ * 函数tinyOpenFile读取path处的文件并返回其扫描器，无法读取时返回NULL；
+ * listing接收回显/跟踪输出，可以为NULL
+ */
+TINY_API TinyScanner *tinyOpenFile(const char *path, unsigned flags, FILE *listing);
+
+/* Function tinyOpenBuffer returns a scanner over the
+ * len bytes at buf, which must outlive the scanner
+ * 函数tinyOpenBuffer返回buf中len个字节的扫描器，buf的生存期必须长于扫描器
+ */
+TINY_API TinyScanner *tinyOpenBuffer(const char *buf, size_t len, unsigned flags, FILE *listing);
+
+/* Function tinyNextToken returns the next token,
+ * TINY_ENDFILE once the source is exhausted
+ * 函数tinyNextToken返回下一个token，源程序结束后返回TINY_ENDFILE
+ */
+TINY_API TinyTokenType tinyNextToken(TinyScanner *scanner);
+
+/* lexeme, line, and NUM/FNUM value of the last token */
+/* 最近一个token的词素、行号以及NUM/FNUM的值 */
+TINY_API const char *tinyTokenString(const TinyScanner *scanner);
+TINY_API int tinyTokenLine(const TinyScanner *scanner);
+TINY_API int tinyTokenValue(const TinyScanner *scanner);
+TINY_API double tinyTokenFloat(const TinyScanner *scanner);
+
+/* Function tinyTokenLiteral returns the index of the
+ * last STR token in the scanner's string pool, or -1
+ * for other tokens or without TINY_STRING_POOL; equal
+ * literals share an index
+ * 函数tinyTokenLiteral返回最近一个STR token在扫描器字符串池中的编号，
+ * 其他token或未使用TINY_STRING_POOL时返回-1；相同的字面量编号相同
+ */
+TINY_API int tinyTokenLiteral(const TinyScanner *scanner);
+
+/* Function tinyLiteralCount returns the number of
+ * distinct string literals pooled so far
+ * 函数tinyLiteralCount返回目前池中不同字符串字面量的个数
+ */
+TINY_API int tinyLiteralCount(const TinyScanner *scanner);
+
+/* Function tinyLiteral returns the text of pooled
+ * literal index without its quotes, NUL-terminated, and
+ * stores its length in len, or returns NULL if there is
+ * no such literal; the text moves when a new literal
+ * is pooled
+ * 函数tinyLiteral返回池中编号为index的字面量文本（不含引号，以NUL结尾）
+ * 并将长度存入len，不存在时返回NULL；加入新字面量时文本位置会改变
+ */
+TINY_API const char *tinyLiteral(const TinyScanner *scanner, int index, size_t *len);
+
+/* Function tinyTokenOffset returns the byte offset
+ * of the first character of the last token
+ * 函数tinyTokenOffset返回最近一个token首字符的字节偏移
+ */
+TINY_API size_t tinyTokenOffset(const TinyScanner *scanner);
+
+/* Function tinyLocate converts a byte offset to a
+ * 1-based line and column, returning 0 if the offset is
+ * past the end; the first call indexes the line starts
+ * 函数tinyLocate将字节偏移转换为从1开始的行号和列号，偏移越界时返回0；
+ * 第一次调用时建立行首索引
+ */
+TINY_API int tinyLocate(TinyScanner *scanner, size_t offset, int *line, int *column);
+
+/* Function tinyLineText returns the text of a line
+ * without its newline and stores its length in len,
+ * or returns NULL if there is no such line
+ * 函数tinyLineText返回一行的文本（不含换行符）并将长度存入len，
+ * 不存在该行时返回NULL
+ */
+TINY_API const char *tinyLineText(TinyScanner *scanner, int line, size_t *len);
+
+/* Function tinyErrorCount returns the number of
+ * errors found so far
+ * 函数tinyErrorCount返回目前发现的错误数
+ */
+TINY_API int tinyErrorCount(const TinyScanner *scanner);
+
+/* the scanner state between two tokens, saved by
+ * tinySave; its fields are private to the library
+ * 两个token之间的扫描器状态，由tinySave保存；其字段为库私有
+ */
+typedef struct {
+    size_t pos;
+    size_t lineEnd;
+    int lineno;
+    int errors;
+    int commentLine;
+    int stringLine;
+    unsigned flags;
+    int diags;
+    int merged;
+    int stopped;
+} TinyCheckpoint;
+
+/* Function tinySave saves the state of the scanner
+ * after its last token
+ * 函数tinySave保存扫描器在最近一个token之后的状态
+ */
+TINY_API void tinySave(const TinyScanner *scanner, TinyCheckpoint *checkpoint);
+
+/* Function tinyRestore returns the scanner to a saved
+ * state, so that the next token is scanned again; the
+ * accessors of the last token are valid again after
+ * the next tinyNextToken, diagnostics collected since
+ * the save are dropped, and echo and trace output
+ * already written is not taken back; a checkpoint may
+ * also be restored on another scanner opened with the
+ * same flags over a source with the same bytes up to
+ * the saved position, which then goes on with the saved
+ * line and error count but without the diagnostics and
+ * pooled literals the first scanner collected before
+ * the save
+ * 函数tinyRestore将扫描器恢复到保存的状态，下一个token将被重新扫描；
+ * 最近token的访问函数在下一次tinyNextToken后才重新有效，保存之后收集的诊断被丢弃，
+ * 已写出的回显和跟踪输出不会撤回；检查点也可以在另一个以相同标志打开、且源程序在
+ * 保存位置之前字节相同的扫描器上恢复，该扫描器沿用保存的行号和错误数，
+ * 但不带有第一个扫描器在保存之前收集的诊断和池中的字面量
+ */
+TINY_API void tinyRestore(TinyScanner *scanner, const TinyCheckpoint *checkpoint);
+
+/* a token held by a lookahead buffer */
+/* 预读缓冲区中的token */
+typedef struct {
+    TinyTokenType kind;
+    int line;
+    size_t offset;
+    int value;
+    double fvalue;
+    TinyCheckpoint before; /* scanner state before the token */
+    char text[TINY_MAXTOKENLEN + 1];
+} TinyToken;
+
+/* a buffer of up to k tokens read ahead of a parser */
+/* 为语法分析器预读至多k个token的缓冲区 */
+typedef struct TinyLookahead TinyLookahead;
+
+/* Function tinyLookaheadOpen returns a buffer of k
+ * tokens over scanner, or NULL when out of memory
+ * 函数tinyLookaheadOpen返回scanner上k个token的缓冲区，内存不足时返回NULL
+ */
+TINY_API TinyLookahead *tinyLookaheadOpen(TinyScanner *scanner, int k);
+
+/* Function tinyPeek returns the token i places ahead,
+ * 0 <= i < k, scanning it if needed, or NULL for any
+ * other i; past the end of the source it returns the
+ * TINY_ENDFILE token
+ * 函数tinyPeek返回前方第i个token（0 <= i < k），需要时扫描它，i为其他值时返回NULL；
+ * 源程序结束后返回TINY_ENDFILE token
+ */
+TINY_API const TinyToken *tinyPeek(TinyLookahead *la, int i);
+
+/* Function tinyAdvance consumes the next token and
+ * returns it; it stays valid until the next tinyPeek
+ * 函数tinyAdvance消耗下一个token并返回它；它在下一次tinyPeek之前有效
+ */
+TINY_API const TinyToken *tinyAdvance(TinyLookahead *la);
+
+/* Functions tinyMark and tinyReset save the position
+ * of the next token and return to it, dropping the
+ * tokens read ahead
+ * 函数tinyMark和tinyReset保存下一个token的位置并回到该位置，丢弃已预读的token
+ */
+TINY_API void tinyMark(TinyLookahead *la, TinyCheckpoint *checkpoint);
+TINY_API void tinyReset(TinyLookahead *la, const TinyCheckpoint *checkpoint);
+
+/* Function tinyLookaheadClose frees the buffer but not
+ * its scanner
+ * 函数tinyLookaheadClose释放缓冲区，但不释放其扫描器
+ */
+TINY_API void tinyLookaheadClose(TinyLookahead *la);
+
+/* one chunk of a source scanned in parallel with the
+ * others; its fields are private to the library
+ * 与其他块并行扫描的源程序的一个块；其字段为库私有
+ */
+typedef struct {
+    size_t begin;            /* first byte of the chunk */
+    size_t end;              /* end of the chunk */
+    size_t resume[3];        /* first line start in code, for each context at begin */
+    int lines[3];            /* newlines before resume */
+    unsigned char exit[3];   /* context at end, for each context at begin */
+    int newlines;            /* newlines in the chunk */
+    size_t start;            /* first byte of the chunk's tokens */
+    size_t stop;             /* end of the chunk's tokens */
+    int line;                /* lines before start */
+    int last;                /* the chunk's tokens end the source */
+} TinyChunk;
+
+/* Function tinyChunkSplit divides the len bytes at buf
+ * into count chunks that begin at line starts
+ * 函数tinyChunkSplit将buf中的len个字节分成count个从行首开始的块
+ */
+TINY_API void tinyChunkSplit(const char *buf, size_t len, TinyChunk *chunks, int count);
+
+/* Function tinyChunkScan finds, for each way chunk may
+ * begin (in code, in a comment, in a string), where
+ * that context ends; chunks may be scanned on separate
+ * threads
+ * 函数tinyChunkScan对块开始时的每种情况（代码中、注释中、字符串中）
+ * 找出该情况在何处结束；各块可以在不同线程上扫描
+ */
+TINY_API void tinyChunkScan(const char *buf, TinyChunk *chunk);
+
+/* Function tinyChunkLink follows the contexts through
+ * the scanned chunks, settling which tokens and line
+ * numbers belong to each; a chunk with no line start
+ * in code gives its bytes to the chunk before it
+ * 函数tinyChunkLink沿已扫描的块传递上下文，确定每个块的token和行号；
+ * 没有处于代码中的行首的块将其字节交给前一个块
+ */
+TINY_API void tinyChunkLink(TinyChunk *chunks, int count);
+
+/* Function tinyOpenChunk returns a scanner over the
+ * tokens of a linked chunk of the source at buf; the
+ * tokens, line numbers and listing of the chunks, in
+ * order, are those of one scanner over the source, and
+ * only the last chunk's TINY_ENDFILE reports the errors
+ * at the end of the source
+ * 函数tinyOpenChunk返回buf处源程序中一个已连接块的token的扫描器；
+ * 按顺序排列的各块的token、行号和列表与整个源程序的一个扫描器相同，
+ * 只有最后一个块的TINY_ENDFILE报告源程序末尾的错误
+ */
+TINY_API TinyScanner *tinyOpenChunk(const char *buf, const TinyChunk *chunk, unsigned flags, FILE *listing);
+
+/* kinds of diagnostics */
+/* 诊断的种类 */
+typedef enum {
+    TINY_DIAG_CHAR,         /* invalid characters */
+    TINY_DIAG_ASSIGN,       /* ':' not followed by '=' */
+    TINY_DIAG_EXPONENT,     /* exponent without digits */
+    TINY_DIAG_SEPARATE,     /* number run into letters */
+    TINY_DIAG_OVERFLOW,     /* number out of range */
+    TINY_DIAG_STRADDLE,     /* string straddles lines */
+    TINY_DIAG_OPEN_STRING,  /* unterminated string */
+    TINY_DIAG_OPEN_COMMENT, /* unterminated comment */
+    TINY_DIAG_LIMIT         /* error limit reached, scanning stopped */
+} TinyDiagCode;
+
+/* a diagnostic collected with TINY_DIAGNOSTICS; a run
+ * of invalid characters with no token between them is
+ * one diagnostic
+ * 使用TINY_DIAGNOSTICS收集的诊断；中间没有token的一串非法字符为一个诊断
+ */
+typedef struct {
+    TinyDiagCode code;
+    int line;        /* line of the first byte */
+    int endLine;     /* line of the last byte */
+    size_t offset;   /* offset of the first byte */
+    size_t length;   /* bytes of source covered */
+    int count;       /* errors merged into this one */
+} TinyDiagnostic;
+
+/* Function tinySetErrorLimit stops scanning once
+ * limit diagnostics are collected, so that the next
+ * token is TINY_ENDFILE; 0 means no limit
+ * 函数tinySetErrorLimit在收集到limit个诊断后停止扫描，下一个token为TINY_ENDFILE；
+ * 0表示不限制
+ */
+TINY_API void tinySetErrorLimit(TinyScanner *scanner, int limit);
+
+/* Function tinyDiagnostics returns the diagnostics
+ * collected so far and stores their number in count
+ * 函数tinyDiagnostics返回目前收集的诊断，并将个数存入count
+ */
+TINY_API const TinyDiagnostic *tinyDiagnostics(const TinyScanner *scanner, int *count);
+
+/* Function tinyPrintDiagnostics writes the collected
+ * diagnostics of the source called name to out, as
+ * text lines or, when json is nonzero, as one JSON
+ * object
+ * 函数tinyPrintDiagnostics将名为name的源程序收集到的诊断写入out，
+ * 为文本行，json非0时为一个JSON对象
+ */
+TINY_API void tinyPrintDiagnostics(TinyScanner *scanner, const char *name, FILE *out, int json);
+
+/* a binary trace event, recorded for every token when
+ * the scanner is opened with TINY_TRACE_BINARY; the
+ * lexeme is the length bytes of source at offset
+ * 二进制跟踪事件，使用TINY_TRACE_BINARY打开扫描器时为每个token记录一个；
+ * 词素是源程序中offset处的length个字节
+ */
+typedef struct {
+    uint64_t time;   /* nanoseconds since the scanner was opened */
+    uint64_t offset; /* offset of the first character of the token */
+    uint32_t length; /* bytes of source up to the end of the token */
+    int32_t line;    /* lines read when the token ended */
+    uint16_t kind;   /* TinyTokenType of the token */
+    uint16_t flags;  /* TINY_TRACE_* errors found with the token */
+} TinyTraceEvent;
+
+/* error flags of a trace event */
+/* 跟踪事件的错误标志 */
+#define TINY_TRACE_OVERFLOW     0x1 /* number out of range */
+#define TINY_TRACE_STRADDLE     0x2 /* string straddles lines */
+#define TINY_TRACE_OPEN_STRING  0x4 /* unterminated string at end of file */
+#define TINY_TRACE_OPEN_COMMENT 0x8 /* unterminated comment at end of file */
+
+/* Function tinyTraceRead moves up to max of the oldest
+ * recorded trace events to events and returns how many
+ * it moved; the scanner keeps the latest 4096 events,
+ * so callers should read at least that often
+ * 函数tinyTraceRead将最早记录的至多max个跟踪事件移到events中并返回个数；
+ * 扫描器只保留最近4096个事件，调用者至少应每隔这么多token读取一次
+ */
+TINY_API size_t tinyTraceRead(TinyScanner *scanner, TinyTraceEvent *events, size_t max);
+
+/* node kinds, statement and expression kinds and
+ * expression types of a syntax tree
+ * 语法树的节点种类、语句与表达式种类以及表达式类型
+ */
+typedef enum { TINY_STMTK, TINY_EXPK } TinyNodeKind;
+typedef enum { TINY_IFK, TINY_REPEATK, TINY_ASSIGNK, TINY_READK, TINY_WRITEK } TinyStmtKind;
+typedef enum { TINY_OPK, TINY_CONSTK, TINY_IDK, TINY_STRK } TinyExpKind;
+typedef enum { TINY_VOID, TINY_INTEGER, TINY_BOOLEAN } TinyExpType;
+
+/* TINY_MAXCHILDREN = the most children of a node */
+/* TINY_MAXCHILDREN =节点子节点的最大数目 */
+#define TINY_MAXCHILDREN 3
+
+/* a node of an AST file, the binary form of a syntax
+ * tree; links are indexes relative to the node itself,
+ * always forward, 0 for none
+ * AST文件（语法树的二进制形式）中的节点；链接为相对于节点自身的下标，总是向后，0表示没有
+ */
+typedef struct {
+    int32_t child[TINY_MAXCHILDREN];
+    int32_t sibling;
+    int32_t lineno;
+    int32_t attr;      /* TinyTokenType of an op, val, or name, see tinyAstName */
+    uint8_t nodekind;  /* TinyNodeKind */
+    uint8_t kind;      /* TinyStmtKind or TinyExpKind */
+    uint8_t type;      /* TinyExpType */
+    uint8_t pad;
+} TinyAstNode;
+
+/* an AST file mapped into memory */
+/* 映射到内存中的AST文件 */
+typedef struct TinyAstFile TinyAstFile;
+
+/* Function tinyAstOpen maps the AST file at path and
+ * checks that its nodes form one tree, returning NULL
+ * if it is not a valid file
+ * 函数tinyAstOpen映射path处的AST文件并检查其节点构成一棵树，不是合法文件时返回NULL
+ */
+TINY_API TinyAstFile *tinyAstOpen(const char *path);
+
+/* Function tinyAstNodes returns the nodes of file in
+ * preorder, root first, and stores their number in
+ * count
+ * 函数tinyAstNodes按先序返回file的节点（根在最前），并将节点数存入count
+ */
+TINY_API const TinyAstNode *tinyAstNodes(const TinyAstFile *file, uint32_t *count);
+
+/* Function tinyAstName returns the name of an assign,
+ * read or identifier node of file
+ * 函数tinyAstName返回file中赋值、读或标识符节点的名字
+ */
+TINY_API const char *tinyAstName(const TinyAstFile *file, const TinyAstNode *node);
+
+/* Procedure tinyAstClose unmaps file */
+/* 过程tinyAstClose解除file的映射 */
+TINY_API void tinyAstClose(TinyAstFile *file);
+
+/* Function tinyClose frees the scanner */
+/* 函数tinyClose释放扫描器 */
+TINY_API void tinyClose(TinyScanner *scanner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,29 @@
+/****************************************************/
+/* File: trace.h                                    */
+/* Binary scan trace files for the TINY compiler    */
+/* 扫描的二进制跟踪文件                             */
+/****************************************************/
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/* TRACE_ENV names the environment variable holding the
+ * path of a binary trace file; when it is set the
+ * listing holds no echo or token lines, and the events
+ * go to the file instead
+ * TRACE_ENV是保存二进制跟踪文件路径的环境变量，设置后列表中不含回显和token行，
+ * 事件写入该文件
+ */
+#define TRACE_ENV "TINY_TRACE_FILE"
+
+/* a trace file is TRACE_MAGIC followed by the
+ * TinyTraceEvent records of each source in turn, in
+ * the byte order of the machine that wrote it; the
+ * ENDFILE event ends the records of a source
+ * 跟踪文件由TRACE_MAGIC和各个源程序依次的TinyTraceEvent记录组成，
+ * 字节序为写入机器的字节序；ENDFILE事件结束一个源程序的记录
+ */
+#define TRACE_MAGIC "TINYTRC1"
+#define TRACE_MAGIC_LEN 8
+
+#endif
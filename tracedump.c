@@ -0,0 +1,158 @@
+/****************************************************/
+/* File: tracedump.c                                */
+/* Renders a binary scan trace as the text listing  */
+/* 将二进制扫描跟踪还原为文本列表                   */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "trace.h"
+
+/* a source being rendered, with the lines echoed so
+   far and a cursor for finding the line of an offset */
+/* 正在还原的源程序，包括已回显的行以及查找偏移所在行的游标 */
+typedef struct {
+    const char *text;
+    size_t len;
+    int echoed;      /* lines echoed so far */
+    size_t next;     /* start of the next line to echo */
+    size_t cursor;   /* offset whose line is cursorLine */
+    int cursorLine;
+} Source;
+
+/* echoTo echoes the lines of src up to line */
+/* echoTo回显src直到第line行 */
+static void echoTo(Source *src, int line) {
+    while (src->echoed < line && src->next < src->len) {
+        const char *nl = memchr(src->text + src->next, '\n', src->len - src->next);
+        size_t end = nl != NULL ? (size_t) (nl - src->text) + 1 : src->len;
+        printf("%d: %.*s", ++src->echoed, (int) (end - src->next), src->text + src->next);
+        src->next = end;
+    }
+}
+
+/* lineOf returns the line of offset, which must not
+   precede the offset of the previous call */
+/* lineOf返回offset所在的行，offset不能小于上一次调用的offset */
+static int lineOf(Source *src, size_t offset) {
+    while (src->cursor < offset) {
+        const char *nl = memchr(src->text + src->cursor, '\n', offset - src->cursor);
+        if (nl == NULL)
+            break;
+        src->cursor = (size_t) (nl - src->text) + 1;
+        src->cursorLine++;
+    }
+    return src->cursorLine;
+}
+
+/* render prints the listing of src from the events in
+   trace up to its ENDFILE event, returning false if
+   the trace ends first */
+/* render根据trace中直到ENDFILE的事件打印src的列表，跟踪提前结束时返回false */
+static bool render(Source *src, FILE *trace) {
+    TinyTraceEvent e;
+    char lexeme[MAXTOKENLEN + 2];
+    while (fread(&e, sizeof(e), 1, trace) == 1) {
+        size_t start = (size_t) e.offset;
+        size_t n = e.length;
+        int lineno = e.line;
+        int first = lineOf(src, start);
+        echoTo(src, lineno);
+        if (e.kind == ENDFILE) {
+            if (src->len == 0 || src->text[src->len - 1] != '\n')
+                printf("\n%d: ", ++lineno);
+            printToken(stdout, ENDFILE, "");
+            if (e.flags & TINY_TRACE_OPEN_STRING)
+                printf("\nError, the line %d of string right quote match error.", first);
+            if (e.flags & TINY_TRACE_STRADDLE)
+                printf("\nError, string straddle between line %d and line %d!", first, lineno);
+            if (e.flags & TINY_TRACE_OPEN_COMMENT)
+                printf("\nError, the line %d of comment right parenthesis matching error.", first);
+            printf("\n");
+            return true;
+        }
+        /* STR的词素不含两边的引号 */
+        if (e.kind == STR && n >= 2) {
+            start++;
+            n -= 2;
+        }
+        if (n > MAXTOKENLEN + 1)
+            n = MAXTOKENLEN + 1;
+        memcpy(lexeme, src->text + start, n);
+        lexeme[n] = '\0';
+        printf("\t%d: ", lineno);
+        printToken(stdout, (TokenType) e.kind, lexeme);
+        if ((e.kind == NUM || e.kind == FNUM) && (e.flags & TINY_TRACE_OVERFLOW))
+            printf("\tError, the line %d of number out of range!\n", lineno);
+        if (e.kind == STR && (e.flags & TINY_TRACE_STRADDLE))
+            printf("\tError, string straddle between line %d and line %d!\n", first, lineno);
+    }
+    return false;
+}
+
+/* readFile reads the file at path into a new buffer */
+/* readFile将path处的文件读入新的缓冲区 */
+static char *readFile(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    char *buf = NULL;
+    size_t cap = 0;
+    size_t n;
+    *len = 0;
+    if (f == NULL)
+        return NULL;
+    do {
+        if (*len == cap) {
+            char *t = (char *) realloc(buf, cap = cap ? 2 * cap : 65536);
+            if (t == NULL) {
+                free(buf);
+                fclose(f);
+                return NULL;
+            }
+            buf = t;
+        }
+        n = fread(buf + *len, 1, cap - *len, f);
+        *len += n;
+    } while (n > 0);
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char *argv[]) {
+    char magic[TRACE_MAGIC_LEN];
+    FILE *trace;
+    int status = 0;
+    int i;
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <trace> <filename>...\n", argv[0]);
+        exit(1);
+    }
+    trace = fopen(argv[1], "rb");
+    if (trace == NULL) {
+        fprintf(stderr, "File %s not found\n", argv[1]);
+        exit(1);
+    }
+    if (fread(magic, 1, TRACE_MAGIC_LEN, trace) != TRACE_MAGIC_LEN || memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_LEN)) {
+        fprintf(stderr, "%s is not a TINY trace file\n", argv[1]);
+        exit(1);
+    }
+    for (i = 2; i < argc; i++) {
+        Source src = {NULL, 0, 0, 0, 0, 1};
+        /* 无法读取的源程序在跟踪中也没有记录 */
+        src.text = readFile(argv[i], &src.len);
+        if (src.text == NULL) {
+            fprintf(stderr, "File %s not found\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        printf("\nTINY COMPILATION: %s\n\n", argv[i]);
+        if (!render(&src, trace)) {
+            fprintf(stderr, "Trace ends before %s does\n", argv[i]);
+            free((char *) src.text);
+            exit(1);
+        }
+        free((char *) src.text);
+    }
+    fclose(trace);
+    return status;
+}
@@ -13,7 +13,7 @@
  * and its lexeme to the listing file
  * 过程printToken将token及其词素打印到列表文件
  */
-void printToken(TokenType token, const char *tokenString) {
+void printToken(FILE *listing, TokenType token, const char *tokenString) {
     switch (token) {
         case TRUE:
         case FALSE:
@@ -56,33 +56,20 @@ void printToken(TokenType token, const char *tokenString) {
             fprintf(listing, "SYM, val= %s\n", tokenString);
             break;
         case ENDFILE:
+            /* 未闭合的string和comment由扫描器在其后报告 */
             fprintf(listing, "EOF");
-            /*字符串是否闭合*/
-            if (!StringOver)
-                fprintf(listing, "\nError, the line %d of string right quote match error.", StringLine);
-            /*字符串是否跨行*/
-            if (StringStraddle) {
-                fprintf(listing, "\nError, string straddle between line %d and line %d!", StringLine, lineno);
-                StringStraddle = false;
-            }
-            /*注释是否闭合*/
-            if (!CommentOver)
-                fprintf(listing, "\nError, the line %d of comment right parenthesis matching error.", CommentLine);
-            fprintf(listing, "\n");
             break;
         case NUM:
             fprintf(listing, "NUM, val= %s\n", tokenString);
             break;
+        case FNUM:
+            fprintf(listing, "FNUM, val= %s\n", tokenString);
+            break;
         case ID:
             fprintf(listing, "ID, name= %s\n", tokenString);
             break;
         case STR:
             fprintf(listing, "STR, val= '%s'\n", tokenString);
-            /*是否跨行*/
-            if (StringStraddle) {
-                fprintf(listing, "\tError, string straddle between line %d and line %d!\n", StringLine, lineno);
-                StringStraddle = false;
-            }
             break;
         case ERROR:
             fprintf(listing, "ERROR: %s\n", tokenString);
@@ -92,22 +79,34 @@ void printToken(TokenType token, const char *tokenString) {
     }
 }
 
+AllocStats allocStats[ALLOC_KINDS];
+
+void countAlloc(AllocKind kind, size_t bytes) {
+#if defined(__GNUC__)
+    __atomic_fetch_add(&allocStats[kind].count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocStats[kind].bytes, (unsigned long) bytes, __ATOMIC_RELAXED);
+#else
+    allocStats[kind].count++;
+    allocStats[kind].bytes += (unsigned long) bytes;
+#endif
+}
+
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  * 函数newStmtNode创建用于语法树构建的新语句节点
  */
-TreeNode *newStmtNode(StmtKind kind) {
+TreeNode *newStmtNode(StmtKind kind, int lineno) {
     TreeNode *t = (TreeNode *) malloc(sizeof(TreeNode));
     int i;
-    if (t == NULL)
-        fprintf(listing, "Out of memory error at line %d\n", lineno);
-    else {
+    if (t != NULL) {
+        countAlloc(ALLOC_STMT, sizeof(TreeNode));
         for (i = 0; i < MAXCHILDREN; i++)
             t->child[i] = NULL;
         t->sibling = NULL;
         t->nodekind = StmtK;
         t->kind.stmt = kind;
         t->lineno = lineno;
+        t->type = Void;
     }
     return t;
 }
@@ -116,12 +115,11 @@ TreeNode *newStmtNode(StmtKind kind) {
  * node for syntax tree construction
  * 函数newExpNode创建用于语法树构建的新表达式节点
  */
-TreeNode *newExpNode(ExpKind kind) {
+TreeNode *newExpNode(ExpKind kind, int lineno) {
     TreeNode *t = (TreeNode *) malloc(sizeof(TreeNode));
     int i;
-    if (t == NULL)
-        fprintf(listing, "Out of memory error at line %d\n", lineno);
-    else {
+    if (t != NULL) {
+        countAlloc(ALLOC_EXP, sizeof(TreeNode));
         for (i = 0; i < MAXCHILDREN; i++)
             t->child[i] = NULL;
         t->sibling = NULL;
@@ -137,48 +135,76 @@ TreeNode *newExpNode(ExpKind kind) {
  * copy of an existing string
  * 函数copyString分配并创建现有字符串的新副本
  */
-char *copyString(char *s) {
+char *copyString(const char *s) {
     int n;
     char *t;
     if (s == NULL)
         return NULL;
     n = strlen(s) + 1;
     t = (char *) malloc(n);
-    if (t == NULL)
-        fprintf(listing, "Out of memory error at line %d\n", lineno);
-    else
+    if (t != NULL) {
+        countAlloc(ALLOC_STRING, (size_t) n);
         strcpy(t, s);
+    }
     return t;
 }
 
-/* Variable indentno is used by printTree to
- * store current number of spaces to indent
- * printTree使用变量indentno来存储要缩进的当前空间数
- */
-static int indentno = 0;
+bool nameSet(Name *name, const char *s) {
+    size_t n = strlen(s);
+    memset(name, 0, sizeof(Name));
+    if (n <= NAMEINLINE) {
+        memcpy(name->inl, s, n);
+        return true;
+    }
+    name->ext.text = (char *) malloc(n + 1);
+    if (name->ext.text == NULL)
+        return false;
+    countAlloc(ALLOC_STRING, n + 1);
+    memcpy(name->ext.text, s, n + 1);
+    name->ext.len = (uint32_t) n;
+    name->ext.tag = NAMEEXTERNAL;
+    return true;
+}
+
+const char *nameText(const Name *name) {
+    return name->ext.tag == NAMEEXTERNAL ? name->ext.text : name->inl;
+}
 
-/* macros to increase/decrease indentation */
-/* 宏以增加/减少缩进 */
-#define INDENT indentno += 2
-#define UNINDENT indentno -= 2
+bool nameEqual(const Name *a, const Name *b) {
+    uint64_t wa[2];
+    uint64_t wb[2];
+    if (a->ext.tag != b->ext.tag)
+        return false;
+    if (a->ext.tag == NAMEEXTERNAL)
+        return a->ext.len == b->ext.len && memcmp(a->ext.text, b->ext.text, a->ext.len) == 0;
+    /* 短名字以NUL填充，两个机器字相等即名字相等 */
+    memcpy(wa, a->inl, sizeof(wa));
+    memcpy(wb, b->inl, sizeof(wb));
+    return wa[0] == wb[0] && wa[1] == wb[1];
+}
+
+void nameFree(Name *name) {
+    if (name->ext.tag == NAMEEXTERNAL)
+        free(name->ext.text);
+    memset(name, 0, sizeof(Name));
+}
 
 /* printSpaces indents by printing spaces */
 /* printSpaces通过打印空间缩进 */
-static void printSpaces(void) {
+static void printSpaces(FILE *listing, int indentno) {
     int i;
     for (i = 0; i < indentno; i++)
         fprintf(listing, " ");
 }
 
-/* procedure printTree prints a syntax tree to the 
- * listing file using indentation to indicate subtrees
- * 过程printTree使用缩进将语法树打印到列表文件中以指示子树
+/* printSubtree prints tree indented by indentno
+ * spaces, its children indented two more
+ * printSubtree以indentno个空格缩进打印tree，其子树再多缩进两格
  */
-void printTree(TreeNode *tree) {
+static void printSubtree(FILE *listing, TreeNode *tree, int indentno) {
     int i;
-    INDENT;
     while (tree != NULL) {
-        printSpaces();
+        printSpaces(listing, indentno);
         if (tree->nodekind == StmtK) {
             switch (tree->kind.stmt) {
                 case IfK:
@@ -188,10 +214,10 @@ void printTree(TreeNode *tree) {
                     fprintf(listing, "Repeat\n");
                     break;
                 case AssignK:
-                    fprintf(listing, "Assign to: %s\n", tree->attr.name);
+                    fprintf(listing, "Assign to: %s\n", nameText(&tree->attr.name));
                     break;
                 case ReadK:
-                    fprintf(listing, "Read: %s\n", tree->attr.name);
+                    fprintf(listing, "Read: %s\n", nameText(&tree->attr.name));
                     break;
                 case WriteK:
                     fprintf(listing, "Write\n");
@@ -204,13 +230,16 @@ void printTree(TreeNode *tree) {
             switch (tree->kind.exp) {
                 case OpK:
                     fprintf(listing, "Op: ");
-                    printToken(tree->attr.op, "\0");
+                    printToken(listing, tree->attr.op, "\0");
                     break;
                 case ConstK:
                     fprintf(listing, "Const: %d\n", tree->attr.val);
                     break;
                 case IdK:
-                    fprintf(listing, "Id: %s\n", tree->attr.name);
+                    fprintf(listing, "Id: %s\n", nameText(&tree->attr.name));
+                    break;
+                case StrK:
+                    fprintf(listing, "Str: #%d\n", tree->attr.val);
                     break;
                 default:
                     fprintf(listing, "Unknown ExpNode kind\n");
@@ -219,8 +248,15 @@ void printTree(TreeNode *tree) {
         } else
             fprintf(listing, "Unknown node kind\n");
         for (i = 0; i < MAXCHILDREN; i++)
-            printTree(tree->child[i]);
+            printSubtree(listing, tree->child[i], indentno + 2);
         tree = tree->sibling;
     }
-    UNINDENT;
+}
+
+/* procedure printTree prints a syntax tree to the 
+ * listing file using indentation to indicate subtrees
+ * 过程printTree使用缩进将语法树打印到列表文件中以指示子树
+ */
+void printTree(FILE *listing, TreeNode *tree) {
+    printSubtree(listing, tree, 2);
 }
@@ -12,30 +12,80 @@
  * and its lexeme to the listing file
  * 过程printToken打印token和它的词素到列表文件
  */
-void printToken(TokenType, const char *);
+void printToken(FILE *, TokenType, const char *);
 
 /* Function newStmtNode creates a new statement
- * node for syntax tree construction
- * 函数newStmtNode创建用于语法树构建的新语句节点
+ * node at line lineno for syntax tree construction,
+ * or returns NULL when out of memory
+ * 函数newStmtNode创建用于语法树构建的新语句节点，内存不足时返回NULL
  */
-TreeNode *newStmtNode(StmtKind);
+TreeNode *newStmtNode(StmtKind, int lineno);
 
 /* Function newExpNode creates a new expression 
- * node for syntax tree construction
- * 函数newExpNode创建用于语法树构建的新表达式节点
+ * node at line lineno for syntax tree construction,
+ * or returns NULL when out of memory
+ * 函数newExpNode创建用于语法树构建的新表达式节点，内存不足时返回NULL
  */
-TreeNode *newExpNode(ExpKind);
+TreeNode *newExpNode(ExpKind, int lineno);
 
 /* Function copyString allocates and makes a new
  * copy of an existing string
  * 函数copyString分配并创建现有字符串的新副本
  */
-char *copyString(char *);
+char *copyString(const char *);
+
+/* Function nameSet stores s in name, in place when
+ * it is short; it returns false when out of memory
+ * 函数nameSet将s存入name，短名字就地保存；内存不足时返回false
+ */
+bool nameSet(Name *name, const char *s);
+
+/* Function nameText returns the text of name */
+/* 函数nameText返回name的文本 */
+const char *nameText(const Name *name);
+
+/* Function nameEqual compares two names by length
+ * and words instead of by characters
+ * 函数nameEqual按长度和机器字比较两个名字，而不是逐个字符比较
+ */
+bool nameEqual(const Name *a, const Name *b);
+
+/* Procedure nameFree frees the buffer of a long name */
+/* 过程nameFree释放长名字的缓冲区 */
+void nameFree(Name *name);
+
+/* allocation sites counted for the time report */
+/* 时间报告中统计的分配位置 */
+typedef enum {
+    ALLOC_STMT,    /* newStmtNode */
+    ALLOC_EXP,     /* newExpNode */
+    ALLOC_STRING,  /* copyString */
+    ALLOC_SCANNER, /* scanner state and buffers */
+    ALLOC_SOURCE,  /* source text read by the driver */
+    ALLOC_KINDS
+} AllocKind;
+
+/* allocStats counts the allocations and bytes of each
+ * site since the program started
+ * allocStats统计程序启动以来每个位置的分配次数和字节数
+ */
+typedef struct {
+    unsigned long count;
+    unsigned long bytes;
+} AllocStats;
+
+extern AllocStats allocStats[ALLOC_KINDS];
+
+/* Procedure countAlloc counts an allocation of bytes
+ * at site kind; it may be called from any thread
+ * 过程countAlloc统计kind位置的一次bytes字节的分配，可以在任何线程调用
+ */
+void countAlloc(AllocKind kind, size_t bytes);
 
 /* procedure printTree prints a syntax tree to the 
  * listing file using indentation to indicate subtrees
  * 过程printTree使用缩进将语法树打印到列表文件中以指示子树
  */
-void printTree(TreeNode *);
+void printTree(FILE *, TreeNode *);
 
 #endif
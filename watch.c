@@ -0,0 +1,208 @@
+/****************************************************/
+/* File: watch.c                                    */
+/* Watch mode implementation                        */
+/* 监视模式的实现                                   */
+/****************************************************/
+
+#include "globals.h"
+#include "server.h"
+#include "watch.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+/* the scanner state after the last token of a line,
+   and the listing bytes written up to then */
+/* 一行最后一个token之后的扫描器状态，以及此前写出的列表字节数 */
+typedef struct {
+    TinyCheckpoint cp;
+    int line;
+    size_t listed;
+} Mark;
+
+/* a watched file and what its last compile left */
+/* 被监视的文件及其上一次编译的结果 */
+typedef struct {
+    const char *pgm;
+    const char *base;   /* file name within its directory */
+    int wd;             /* inotify watch of the directory */
+    char *text;         /* source as last compiled */
+    size_t len;
+    char *out;          /* listing as last produced */
+    size_t outLen;
+    Mark *marks;
+    int nmarks;
+    int capMarks;
+} Watched;
+
+/* resumeMark returns how many marks of w stay valid
+   when text differs from w->text first at offset diff:
+   those whose lines end before the line of diff */
+/* resumeMark返回text与w->text首次在diff处不同时w中仍有效的标记数：
+   其所在行在diff所在行之前结束的标记 */
+static int resumeMark(const Watched *w, size_t diff) {
+    const char *p = w->text;
+    const char *end = w->text + diff;
+    int line = 1;
+    int n = w->nmarks;
+    while (p < end && (p = memchr(p, '\n', (size_t) (end - p))) != NULL) {
+        p++;
+        line++;
+    }
+    while (n > 0 && w->marks[n - 1].line >= line)
+        n--;
+    return n;
+}
+
+/* recompile compiles text as the new source of w,
+   resuming from the last valid mark when it can */
+/* recompile将text作为w的新源程序编译，能够时从最后一个有效标记继续 */
+static bool recompile(Watched *w, char *text, size_t len, unsigned flags) {
+    char *out = NULL;
+    size_t outLen = 0;
+    FILE *mem = open_memstream(&out, &outLen);
+    TinyScanner *scanner;
+    int keep = 0;
+    int line;
+    if (mem == NULL)
+        return false;
+    scanner = tinyOpenBuffer(text, len, flags, mem);
+    if (scanner == NULL) {
+        fclose(mem);
+        free(out);
+        return false;
+    }
+    if (w->text != NULL) {
+        size_t diff = 0;
+        size_t n = len < w->len ? len : w->len;
+        while (diff < n && text[diff] == w->text[diff])
+            diff++;
+        keep = resumeMark(w, diff);
+    }
+    if (keep > 0) {
+        Mark *m = &w->marks[keep - 1];
+        fwrite(w->out, 1, m->listed, mem);
+        tinyRestore(scanner, &m->cp);
+        line = m->line;
+    } else {
+        fprintf(mem, "\nTINY COMPILATION: %s\n\n", w->pgm);
+        line = 0;
+    }
+    w->nmarks = keep;
+    for (;;) {
+        TinyTokenType token = tinyNextToken(scanner);
+        if (token == TINY_ENDFILE)
+            break;
+        /* 每行记录一次状态 */
+        if (tinyTokenLine(scanner) > line) {
+            if (w->nmarks == w->capMarks) {
+                int cap = w->capMarks ? 2 * w->capMarks : 256;
+                Mark *t = (Mark *) realloc(w->marks, (size_t) cap * sizeof(Mark));
+                if (t == NULL)
+                    continue;
+                w->marks = t;
+                w->capMarks = cap;
+            }
+            line = tinyTokenLine(scanner);
+            w->marks[w->nmarks].line = line;
+            tinySave(scanner, &w->marks[w->nmarks].cp);
+            w->marks[w->nmarks].listed = (size_t) ftell(mem);
+            w->nmarks++;
+        }
+    }
+    tinyClose(scanner);
+    fclose(mem);
+    free(w->text);
+    free(w->out);
+    w->text = text;
+    w->len = len;
+    w->out = out;
+    w->outLen = outLen;
+    fwrite(out, 1, outLen, stdout);
+    fflush(stdout);
+    return true;
+}
+
+/* reload reads w again and recompiles it if it changed */
+/* reload重新读取w，有改变时重新编译 */
+static void reload(Watched *w, unsigned flags) {
+    FILE *f = fopen(w->pgm, "r");
+    char *text = NULL;
+    size_t cap = 0;
+    size_t len;
+    if (f == NULL) {
+        fprintf(stderr, "File %s not found\n", w->pgm);
+        return;
+    }
+    len = readSource(f, &text, &cap);
+    fclose(f);
+    if (len == (size_t) -1) {
+        fprintf(stderr, "Out of memory error reading %s\n", w->pgm);
+        free(text);
+        return;
+    }
+    /* 内容未改变的保存不需要重新编译 */
+    if (w->text != NULL && len == w->len && memcmp(text, w->text, len) == 0) {
+        free(text);
+        return;
+    }
+    if (!recompile(w, text, len, flags)) {
+        fprintf(stderr, "Out of memory error\n");
+        free(text);
+    }
+}
+
+int runWatch(char **pgms, int count, unsigned flags) {
+    Watched *files = (Watched *) calloc((size_t) count, sizeof(Watched));
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int fd = inotify_init1(IN_CLOEXEC);
+    int i;
+    if (files == NULL || fd < 0) {
+        fprintf(stderr, "Unable to start watching\n");
+        free(files);
+        return 1;
+    }
+    for (i = 0; i < count; i++) {
+        /* 监视所在目录，这样以改名方式保存的文件也能被发现 */
+        char *slash = strrchr(pgms[i], '/');
+        char *dir = slash != NULL ? strndup(pgms[i], (size_t) (slash - pgms[i]) + 1) : strdup(".");
+        files[i].pgm = pgms[i];
+        files[i].base = slash != NULL ? slash + 1 : pgms[i];
+        files[i].wd = dir != NULL ? inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) : -1;
+        free(dir);
+        if (files[i].wd < 0) {
+            fprintf(stderr, "Unable to watch %s\n", pgms[i]);
+            return 1;
+        }
+        reload(&files[i], flags);
+    }
+    for (;;) {
+        ssize_t n = read(fd, events, sizeof(events));
+        char *p;
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (p = events; p < events + n; p += sizeof(struct inotify_event) + ((struct inotify_event *) p)->len) {
+            struct inotify_event *ev = (struct inotify_event *) p;
+            for (i = 0; i < count; i++)
+                if (ev->len > 0 && files[i].wd == ev->wd && !strcmp(ev->name, files[i].base))
+                    reload(&files[i], flags);
+        }
+    }
+    fprintf(stderr, "Watching stopped\n");
+    return 1;
+}
+
+#else
+
+int runWatch(char **pgms, int count, unsigned flags) {
+    fprintf(stderr, "Watch mode is not supported on this platform\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,20 @@
+/****************************************************/
+/* File: watch.h                                    */
+/* Watch mode for the TINY compiler                 */
+/* 监视模式                                         */
+/****************************************************/
+
+#ifndef _WATCH_H_
+#define _WATCH_H_
+
+/* Function runWatch compiles the count files in pgms
+ * with scanner flags, then recompiles each one after
+ * it is saved and prints its new listing, until it
+ * fails; a recompile rescans only from the last line
+ * before the first changed byte
+ * 函数runWatch用扫描器标志flags编译pgms中的count个文件，之后每当文件被保存时
+ * 重新编译并打印新的列表，直到出错；重新编译只从第一个改变的字节之前的最后一行开始扫描
+ */
+int runWatch(char **pgms, int count, unsigned flags);
+
+#endif